@@ -2,6 +2,10 @@
 #include <stdlib.h>
 #include <math.h>
 #include <stdbool.h>
+#include <string.h>
+#include "tsplib.h"
+#include "prazo.h"
+#include "profiling.h"
 
 #define N 100         // Tamanho da população de formigas
 #define ALPHA 1.0     // Importância do feromônio
@@ -10,42 +14,39 @@
 #define Q 100         // Quantidade de feromônio depositado por formiga
 #define MAX_ITER 1000 // Número máximo de iterações
 #define INF 1e9       // Infinito
+#define STALL_ITER 50 // Iterações sem melhora antes de reiniciar os feromônios (modo --time-limit)
+#define MAX_PONTOS 4000 // Matriz e feromônios são n x n; instâncias maiores vão para o pipeline
 
-// Estrutura para representar um ponto 3D
-typedef struct
-{
-    int id;
-    double x;
-    double y;
-    double z;
-} Point;
-
-// Função para calcular a distância Euclidiana entre dois pontos 3D
-double dist(Point a, Point b)
-{
-    return sqrt(pow(a.x - b.x, 2) + pow(a.y - b.y, 2) + pow(a.z - b.z, 2));
-}
+int n = 0; // Número de pontos da instância
+
+// --tour arquivo.tour grava o melhor caminho com os ids originais dos pontos
+const char *arquivo_tour = NULL;
+char nome_instancia[128];
 
-// Função para ler coordenadas de um arquivo
-void ler_coordenadas(const char *nome_arquivo, Point points[])
+// Com time_limit > 0 o ACO roda até o prazo, ignorando MAX_ITER e a distância alvo
+double time_limit = 0;
+
+// Distâncias pré-calculadas entre os n pontos (int32 com -DDIST_INTEIRA)
+custo_t *matriz = NULL;
+TipoPeso tipo_peso = PESO_EUCLIDIANO;
+
+// Função para ler os pontos de um arquivo (.xyz.txt ou TSPLIB); define n e
+// retorna os pontos com os ids originais
+Point *ler_coordenadas(const char *nome_arquivo)
 {
-    FILE *arquivo = fopen(nome_arquivo, "r");
-    if (arquivo == NULL)
+    PROF_ESCOPO("leitura");
+    InstanciaTSP instancia;
+    ler_instancia(nome_arquivo, &instancia);
+    if (instancia.n < 3 || instancia.n > MAX_PONTOS)
     {
-        printf("Erro ao abrir o arquivo.\n");
+        fprintf(stderr, "O ACO aceita de 3 a %d pontos; o arquivo tem %d\n", MAX_PONTOS, instancia.n);
         exit(1);
     }
-    int id;
-    double x, y, z;
-    for (int i = 0; i < n; i++)
-    {
-        fscanf(arquivo, "%lf %lf %lf", &x, &y, &z);
-        points[i].id = i;
-        points[i].x = x;
-        points[i].y = y;
-        points[i].z = z;
-    }
-    fclose(arquivo);
+    n = instancia.n;
+    matriz = calcular_matriz(&instancia, n);
+    tipo_peso = instancia.tipo;
+    snprintf(nome_instancia, sizeof(nome_instancia), "%s", instancia.nome);
+    return instancia.points;
 }
 
 // Função para inicializar os feromônios entre os pontos
@@ -61,7 +62,7 @@ void init_pheromones(double **pheromones)
 }
 
 // Função para escolher o próximo ponto a ser visitado pela formiga
-int choose_next_point(bool *visited, int current_point, double **pheromones, Point *points)
+int choose_next_point(bool *visited, int current_point, double **pheromones)
 {
     double total_prob = 0.0;
     double probabilities[n];
@@ -71,7 +72,7 @@ int choose_next_point(bool *visited, int current_point, double **pheromones, Poi
     {
         if (!visited[i])
         {
-            probabilities[i] = pow(pheromones[current_point][i], ALPHA) * pow(1.0 / dist(points[current_point], points[i]), BETA);
+            probabilities[i] = pow(pheromones[current_point][i], ALPHA) * pow(1.0 / ((double)matriz[current_point * n + i] + 1e-10), BETA);
             total_prob += probabilities[i];
         }
         else
@@ -107,20 +108,45 @@ int choose_next_point(bool *visited, int current_point, double **pheromones, Poi
     // Se todos os pontos já foram visitados, retorne -1 (isso não deve acontecer)
     return -1;
 }
-// Função para calcular a distância total de um caminho
-double calc_dist(Point *path, int n)
+// Função para calcular a distância total de um caminho (índices dos pontos),
+// com os mesmos custos da matriz usados na escolha dos pontos
+double calc_dist(const int *path, int n)
 {
+    PROF_ESCOPO("calc_dist");
     double distance = 0.0;
     for (int i = 0; i < n - 1; i++)
     {
-        distance += dist(path[i], path[i + 1]);
+        distance += matriz[path[i] * n + path[i + 1]];
+    }
+    distance += matriz[path[n - 1] * n + path[0]]; // Voltar ao ponto de origem
+    return custo_real(tipo_peso, distance);
+}
+
+// Atualiza os feromônios: evaporação e depósito Q / distância em cada trilha
+void update_pheromones(double **pheromones, int **ant_paths, double *ant_distances, int ants)
+{
+    PROF_ESCOPO("feromonio");
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            pheromones[i][j] *= 1.0 - RHO;
+        }
+    }
+    for (int ant = 0; ant < ants; ant++)
+    {
+        double deposit = Q / ant_distances[ant];
+        for (int i = 0; i < n; i++)
+        {
+            int a = ant_paths[ant][i], b = ant_paths[ant][(i + 1) % n];
+            pheromones[a][b] += deposit;
+            pheromones[b][a] += deposit;
+        }
     }
-    distance += dist(path[n - 1], path[0]); // Voltar ao ponto de origem
-    return distance;
 }
 
 // Função principal para resolver o TSP usando colônia de formigas
-void solve_tsp(Point *points)
+void solve_tsp(Point *points, const Prazo *prazo)
 {
     double **pheromones = malloc(n * sizeof(double *));
     for (int i = 0; i < n; i++)
@@ -132,11 +158,25 @@ void solve_tsp(Point *points)
     Point *best_path = malloc(n * sizeof(Point));
     double best_distance = INF;
 
-    for (int iter = 0; iter < MAX_ITER; iter++)
+    int **ant_paths = malloc(n * sizeof(int *));
+    double *ant_distances = malloc(n * sizeof(double));
+    Point *path = malloc(n * sizeof(Point));
+    for (int ant = 0; ant < n; ant++)
+    {
+        ant_paths[ant] = malloc(n * sizeof(int));
+    }
+
+    int last_improvement = 0;
+    int restarts = 0;
+    double inicio_busca = relogio(); // O prazo já inclui a leitura; o ritmo conta só a busca
+
+    for (int iter = 0; prazo_ativo(prazo) ? !prazo_expirou(prazo) : iter < MAX_ITER; iter++)
     {
-        // Implemente o movimento das formigas entre os pontos aqui
-        for (int ant = 0; ant < n; ant++)
+        // Movimento das formigas entre os pontos
+        int ants = 0;
+        for (int ant = 0; ant < n && !prazo_expirou(prazo); ant++)
         {
+            PROF_ESCOPO("construcao_formiga");
             bool *visited = malloc(n * sizeof(bool));
             for (int i = 0; i < n; i++)
             {
@@ -145,38 +185,65 @@ void solve_tsp(Point *points)
 
             int current_point = 0; // Começando do ponto 0
             visited[current_point] = true;
+            ant_paths[ant][0] = current_point;
 
             for (int step = 1; step < n; step++)
             {
-                int next_point = choose_next_point(visited, current_point, pheromones, points);
-                // Atualize a trilha de feromônio entre current_point e next_point
+                int next_point = choose_next_point(visited, current_point, pheromones);
+                ant_paths[ant][step] = next_point;
                 visited[next_point] = true;
                 current_point = next_point;
             }
             free(visited);
-        }
-        // Atualize os feromônios na trilha
 
-        // Encontre a melhor solução até agora
-        double current_distance = calc_dist(points, n);
-        if (current_distance < best_distance)
-        {
-            best_distance = current_distance;
             for (int i = 0; i < n; i++)
             {
-                best_path[i] = points[i];
+                path[i] = points[ant_paths[ant][i]];
+            }
+            ant_distances[ant] = calc_dist(ant_paths[ant], n);
+            ants++;
+
+            // Encontre a melhor solução até agora
+            if (ant_distances[ant] < best_distance)
+            {
+                best_distance = ant_distances[ant];
+                for (int i = 0; i < n; i++)
+                {
+                    best_path[i] = path[i];
+                }
+                last_improvement = iter;
             }
         }
 
+        // Atualize os feromônios na trilha
+        update_pheromones(pheromones, ant_paths, ant_distances, ants);
+
         printf("rodando");
 
+        // Estagnou: reinicia os feromônios se ainda cabem STALL_ITER iterações no prazo
+        if (prazo_ativo(prazo) && iter - last_improvement >= STALL_ITER)
+        {
+            double per_iteration = (relogio() - inicio_busca) / (iter + 1);
+            if (prazo_restante(prazo) > STALL_ITER * per_iteration)
+            {
+                init_pheromones(pheromones);
+                restarts++;
+            }
+            last_improvement = iter;
+        }
+
         // Critério de parada
-        if (best_distance < 2500)
+        if (!prazo_ativo(prazo) && best_distance < 2500)
         {
             break;
         }
     }
 
+    if (prazo_ativo(prazo))
+    {
+        printf("\nPrazo de %.2f s atingido apos %d reinicios\n", time_limit, restarts);
+    }
+
     // Imprima a melhor solução encontrada
     printf("Melhor caminho encontrado:\n");
     for (int i = 0; i < n; i++)
@@ -185,8 +252,26 @@ void solve_tsp(Point *points)
     }
     printf("Distância total do caminho: %.6f\n", best_distance);
 
+    if (arquivo_tour != NULL)
+    {
+        int *ids = malloc(n * sizeof(int));
+        for (int i = 0; i < n; i++)
+        {
+            ids[i] = best_path[i].id;
+        }
+        gravar_tour(arquivo_tour, nome_instancia, ids, n, best_distance);
+        free(ids);
+    }
+
     // Libere a memória alocada
     free(best_path);
+    free(path);
+    free(ant_distances);
+    for (int ant = 0; ant < n; ant++)
+    {
+        free(ant_paths[ant]);
+    }
+    free(ant_paths);
     for (int i = 0; i < n; i++)
     {
         free(pheromones[i]);
@@ -194,10 +279,27 @@ void solve_tsp(Point *points)
     free(pheromones);
 }
 
-int main()
+int main(int argc, char *argv[])
 {
-    Point points[n];
-    ler_coordenadas("..\\coordenadas\\star100.xyz.txt", points);
-    solve_tsp(points);
+    const char *nome_arquivo = "..\\coordenadas\\star100.xyz.txt";
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--time-limit") == 0 && i + 1 < argc)
+            time_limit = atof(argv[++i]);
+        else if (strcmp(argv[i], "--tour") == 0 && i + 1 < argc)
+            arquivo_tour = argv[++i];
+        else
+            nome_arquivo = argv[i];
+    }
+
+    // O prazo conta desde o início do processo, incluindo a leitura
+    Prazo prazo;
+    prazo_iniciar(&prazo, time_limit);
+
+    Point *points = ler_coordenadas(nome_arquivo);
+    solve_tsp(points, &prazo);
+    PROF_RELATORIO(stdout);
+    free(points);
+    free(matriz);
     return 0;
 }
@@ -0,0 +1,271 @@
+#ifndef BUSCA_LOCAL_H
+#define BUSCA_LOCAL_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include "tsplib.h"
+#include "prazo.h"
+#include "kdtree.h"
+#include "profiling.h"
+
+// Busca local 2-opt sobre listas de candidatos, compartilhada pelo pipeline e
+// pela atualização incremental de tours
+
+#define K_VIZINHOS 10 // Tamanho da lista de candidatos de cada ponto
+
+// Pontos e listas de candidatos (K vizinhos mais próximos, ordenados por distância)
+typedef struct
+{
+    int n;
+    int k;
+    TipoPeso tipo;
+    Point *points;
+    custo_t *matriz;       // n * n, só para instâncias pequenas (senão NULL)
+    int *vizinhos;         // n * k
+    custo_t *custos;       // distância até cada vizinho, alinhado com 'vizinhos'
+    const ArvoreKd *arvore; // Árvore usada para calcular as listas
+    unsigned char *prontos; // NULL se todas as listas já foram calculadas
+    const bool *vivo;       // NULL, ou os pontos que ainda estão no tour (os outros são ignorados)
+    const ArvoreKd *recentes; // NULL, ou árvore auxiliar dos pontos a partir de 'base_recentes'
+    int base_recentes;
+    int max_inversao;       // Maior trecho que um movimento pode inverter (0 = sem limite)
+} Instancia;
+
+static inline custo_t dist_ij(const Instancia *inst, int i, int j)
+{
+    if (inst->matriz != NULL)
+        return inst->matriz[(size_t)i * inst->n + j];
+    return custo_tsplib(inst->tipo, &inst->points[i], &inst->points[j]);
+}
+
+// Função para calcular a distância total de um tour (fechando o ciclo)
+static inline double comprimento_tour(const Instancia *inst, const int *tour)
+{
+    double total = 0.0;
+    for (int i = 0; i < inst->n - 1; i++)
+    {
+        total += dist_ij(inst, tour[i], tour[i + 1]);
+    }
+    total += dist_ij(inst, tour[inst->n - 1], tour[0]);
+    return custo_real(inst->tipo, total);
+}
+
+// Os m->k pontos mais próximos de q (exceto 'excluir') nas árvores da instância
+static inline int buscar_candidatos(const Instancia *inst, const Point *q, int excluir, Melhores *m)
+{
+    buscar_vizinhos(inst->arvore, q, excluir, inst->vivo, m);
+    if (inst->recentes != NULL && inst->recentes->n > 0)
+    {
+        // A árvore auxiliar numera os pontos a partir de 0. A consulta nela
+        // começa com os achados da principal (ids negativos), para já podar
+        // pelo raio deles.
+        int base = inst->base_recentes;
+        int ids[m->k];
+        double d2[m->k];
+        Melhores extra = {m->k, m->total, ids, d2};
+        for (int j = 0; j < m->total; j++)
+        {
+            ids[j] = -1 - m->ids[j];
+            d2[j] = m->d2[j];
+        }
+        buscar_no(inst->recentes, 0, inst->recentes->n, q, excluir - base,
+                  inst->vivo != NULL ? inst->vivo + base : NULL, &extra);
+        m->total = extra.total;
+        for (int j = 0; j < extra.total; j++)
+        {
+            m->ids[j] = ids[j] < 0 ? -1 - ids[j] : ids[j] + base;
+            m->d2[j] = d2[j];
+        }
+    }
+    return m->total;
+}
+
+// Calcula a lista de candidatos do ponto i com a árvore k-d. Se houver menos
+// de k pontos vivos, o último candidato se repete no fim da lista.
+static inline void preencher_vizinhos(const Instancia *inst, int i)
+{
+    int ids[K_VIZINHOS];
+    double d2[K_VIZINHOS];
+    Melhores m = {inst->k, 0, ids, d2};
+    int total = buscar_candidatos(inst, &inst->points[i], i, &m);
+    if (total == 0)
+        return;
+    for (int j = 0; j < inst->k; j++)
+    {
+        int v = ids[j < total ? j : total - 1];
+        inst->vizinhos[(size_t)i * inst->k + j] = v;
+        inst->custos[(size_t)i * inst->k + j] = dist_ij(inst, i, v);
+    }
+}
+
+// Índice do início da lista de candidatos de i, calculando-a se preciso
+static inline size_t lista_vizinhos(const Instancia *inst, int i)
+{
+    if (inst->prontos != NULL && !inst->prontos[i])
+    {
+        preencher_vizinhos(inst, i);
+        inst->prontos[i] = 1;
+    }
+    return (size_t)i * inst->k;
+}
+
+// Quantas posições inverter(i, j) troca de lugar
+static inline int custo_inversao(int n, int i, int j)
+{
+    int tam = j - i;
+    if (tam < 0)
+        tam += n;
+    tam += 1;
+    return 2 * tam > n ? n - tam : tam;
+}
+
+// Inverte o trecho tour[i..j] (circular); se o complemento for menor, inverte ele
+static inline void inverter(int *tour, int *pos, int n, int i, int j)
+{
+    int tam = j - i;
+    if (tam < 0)
+        tam += n;
+    tam += 1;
+    if (2 * tam > n)
+    {
+        int novo_i = (j + 1) % n;
+        j = (i - 1 + n) % n;
+        i = novo_i;
+        tam = n - tam;
+    }
+    for (int s = 0; s < tam / 2; s++)
+    {
+        int temp = tour[i];
+        tour[i] = tour[j];
+        tour[j] = temp;
+        pos[tour[i]] = i;
+        pos[tour[j]] = j;
+        i = (i + 1) % n;
+        j = (j - 1 + n) % n;
+    }
+}
+
+// Busca local 2-opt com listas de candidatos e fila de pontos ativos
+// (don't-look bits) sobre um tour de n pontos. Com 'ativos' == NULL todos os
+// pontos começam na fila, senão só os pontos informados (ex.: extremidades de
+// arestas alteradas). 'pos' traz a posição de cada ponto no tour e continua
+// válido no fim; 'fila' (n posições) e 'na_fila' (tudo false, e assim fica)
+// são do chamador, para quem roda a busca muitas vezes não alocar O(n) a cada
+// chamada. 'prazo' e 'ganho' podem ser NULL; em 'ganho' soma-se a redução do
+// comprimento (em custo_t). Retorna o número de movimentos aplicados.
+static inline long busca_local_em(const Instancia *inst, int *tour, int n, int *pos, int *fila, bool *na_fila,
+                                  const int *ativos, int num_ativos, const Prazo *prazo, double *ganho)
+{
+    PROF_ESCOPO("busca_local_2opt");
+    if (n < 5)
+        return 0;
+
+    int inicio = 0, tam = 0;
+    long movimentos = 0;
+
+#define ENFILEIRAR(p)                         \
+    do                                        \
+    {                                         \
+        int p_ = (p);                         \
+        if (!na_fila[p_])                     \
+        {                                     \
+            na_fila[p_] = true;               \
+            fila[(inicio + tam++) % n] = p_;  \
+        }                                     \
+    } while (0)
+
+    if (ativos == NULL)
+    {
+        for (int i = 0; i < n; i++)
+            ENFILEIRAR(tour[i]);
+    }
+    else
+    {
+        for (int i = 0; i < num_ativos; i++)
+            ENFILEIRAR(ativos[i]);
+    }
+
+    long verificacoes = 0;
+    while (tam > 0)
+    {
+        if ((++verificacoes & 255) == 0 && prazo != NULL && prazo_expirou(prazo))
+        {
+            for (; tam > 0; tam--, inicio = (inicio + 1) % n)
+                na_fila[fila[inicio]] = false;
+            break;
+        }
+
+        int a = fila[inicio];
+        inicio = (inicio + 1) % n;
+        tam--;
+        na_fila[a] = false;
+        size_t lista_a = lista_vizinhos(inst, a);
+
+        // dir 0: arestas (a, suc a) e (c, suc c); dir 1: (pred a, a) e (pred c, c)
+        bool melhorou = false;
+        for (int dir = 0; dir < 2 && !melhorou; dir++)
+        {
+            int pa = pos[a];
+            int b = dir == 0 ? tour[(pa + 1) % n] : tour[(pa - 1 + n) % n];
+            custo_t d_ab = dist_ij(inst, a, b);
+            for (int j = 0; j < inst->k; j++)
+            {
+                custo_t d_ac = inst->custos[lista_a + j];
+                if (d_ac >= d_ab)
+                    break;
+                int c = inst->vizinhos[lista_a + j];
+                if (inst->vivo != NULL && !inst->vivo[c])
+                    continue;
+                int pc = pos[c];
+                int d = dir == 0 ? tour[(pc + 1) % n] : tour[(pc - 1 + n) % n];
+                if (c == b || d == a)
+                    continue;
+
+                custo_t delta = d_ac + dist_ij(inst, b, d) - d_ab - dist_ij(inst, c, d);
+                if (delta < -EPS_CUSTO)
+                {
+                    int i = dir == 0 ? pos[b] : pos[a];
+                    int f = dir == 0 ? pos[c] : pos[d];
+                    if (inst->max_inversao > 0 && custo_inversao(n, i, f) > inst->max_inversao)
+                        continue;
+                    inverter(tour, pos, n, i, f);
+                    if (ganho != NULL)
+                        *ganho -= delta;
+                    ENFILEIRAR(a);
+                    ENFILEIRAR(b);
+                    ENFILEIRAR(c);
+                    ENFILEIRAR(d);
+                    movimentos++;
+                    melhorou = true;
+                    break;
+                }
+            }
+        }
+    }
+#undef ENFILEIRAR
+
+    return movimentos;
+}
+
+// Busca local sobre o tour inteiro da instância (inst->n pontos), com buffers próprios
+static inline long busca_local(const Instancia *inst, int *tour, const int *ativos, int num_ativos, const Prazo *prazo)
+{
+    int n = inst->n;
+    if (n < 5)
+        return 0;
+
+    int *pos = malloc(n * sizeof(int));
+    int *fila = malloc(n * sizeof(int));
+    bool *na_fila = calloc(n, sizeof(bool));
+    for (int i = 0; i < n; i++)
+    {
+        pos[tour[i]] = i;
+    }
+    long movimentos = busca_local_em(inst, tour, n, pos, fila, na_fila, ativos, num_ativos, prazo, NULL);
+    free(pos);
+    free(fila);
+    free(na_fila);
+    return movimentos;
+}
+
+#endif
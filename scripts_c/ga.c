@@ -3,54 +3,57 @@
 #include <math.h>
 #include <stdbool.h>
 #include <string.h>
+#include "tsplib.h"
+#include "prazo.h"
+#include "profiling.h"
 
 // Variaveis globais para gerarGrid
 
 float mutation_rate = 0.05;
 int pop_size = 30;
 int iterations = 100000;
-int n = 100;
+int n = 0; // Número de pontos da instância (definido na leitura)
 float target_distance = 1800;
+const char *arquivo_coordenadas = "..\\coordenadas\\star100.xyz.txt";
+const char *arquivo_tour = NULL; // --tour: grava o melhor caminho com os ids originais
+char nome_instancia[128];
 
-// Estrutura para representar um ponto 3D
-typedef struct
-{
-    int id;
-    double x;
-    double y;
-    double z;
-} Point;
+// Modo anytime: com time_limit > 0 o GA roda até o prazo (ignorando iterations
+// e target_distance) e reinicia a população com double-bridge quando estagna
+double time_limit = 0;
+int stall_generations = 500; // Gerações sem melhorar o incumbente antes do reinício
+
+// Distâncias pré-calculadas entre os n pontos (int32 com -DDIST_INTEIRA)
+custo_t *matriz = NULL;
+TipoPeso tipo_peso = PESO_EUCLIDIANO;
+
+#define MAX_PONTOS 1000 // Capacidade do caminho de cada indivíduo (copiado por valor)
 
 // Estrutura para representar um indivíduo (caminho)
 typedef struct
 {
-    int path[100];
+    int path[MAX_PONTOS];
     double fitness;
 } Individual;
 
-// Calcula a distância euclidiana entre dois pontos 3D
-double distance(Point p1, Point p2)
-{
-    float distancia;
-    distancia = sqrt(pow(p2.x - p1.x, 2) + pow(p2.y - p1.y, 2) + pow(p2.z - p1.z, 2));
-    return distancia;
-}
-
 // Calcula o comprimento do caminho de um indivíduo
 double calculate_fitness(Individual individual, Point points[])
 {
+    PROF_ESCOPO("calculate_fitness");
+    (void)points; // as distâncias vêm da matriz pré-calculada
     double length = 0.0;
     for (int i = 0; i < n - 1; i++)
     {
-        length += distance(points[individual.path[i]], points[individual.path[i + 1]]);
+        length += matriz[individual.path[i] * n + individual.path[i + 1]];
     }
-    length += distance(points[individual.path[n - 1]], points[individual.path[0]]); // fecha o ciclo
-    return length;
+    length += matriz[individual.path[n - 1] * n + individual.path[0]]; // fecha o ciclo
+    return custo_real(tipo_peso, length);
 }
 
 // Inicializa uma população de indivíduos com caminhos aleatórios
 void initialize_population(Individual population[], Point points[])
 {
+    PROF_ESCOPO("initialize_population");
     // Loop através de cada indivíduo na população
     for (int i = 0; i < pop_size; i++)
     {
@@ -83,6 +86,7 @@ void initialize_population(Individual population[], Point points[])
 // Seleciona indivíduos para reprodução usando torneio binário
 Individual tournament_selection(Individual population[])
 {
+    PROF_ESCOPO("tournament_selection");
     Individual parent1 = population[rand() % pop_size];
     Individual parent2 = population[rand() % pop_size];
     return (parent1.fitness < parent2.fitness) ? parent1 : parent2;
@@ -91,6 +95,7 @@ Individual tournament_selection(Individual population[])
 // Realiza o cruzamento entre dois indivíduos para gerar um novo indivíduo
 Individual crossover(Individual parent1, Individual parent2, Point *points)
 {
+    PROF_ESCOPO("crossover");
     int start = rand() % n;
     int end = rand() % n;
     if (start > end)
@@ -176,6 +181,7 @@ void mutate_plus(Individual *individual)
 // Realiza mutação em um indivíduo
 void mutate(Individual *individual)
 {
+    PROF_ESCOPO("mutate");
     if ((double)rand() / RAND_MAX < mutation_rate)
     {
         int start = rand() % (n - 1) + 1; // Ignorar o ponto de partida
@@ -200,6 +206,7 @@ void mutate(Individual *individual)
 // Evolui a população por uma geração e verifica o critério de parada
 bool evolve_population(Individual population[], Point points[])
 {
+    PROF_ESCOPO("evolve_population");
     Individual new_population[pop_size];
     for (int i = 0; i < pop_size; i++)
     {
@@ -208,7 +215,7 @@ bool evolve_population(Individual population[], Point points[])
         Individual child = crossover(parent1, parent2, points);
         mutate(&child);
         new_population[i] = child;
-        if (child.fitness < target_distance)
+        if (time_limit <= 0 && child.fitness < target_distance)
         { // Verifica o critério de parada
             for (int j = 0; j < pop_size; j++)
             {
@@ -238,54 +245,92 @@ Individual find_best_individual(Individual population[])
     return best_individual;
 }
 
-// Função para ler coordenadas de um arquivo
+// Função para ler os pontos de um arquivo (.xyz.txt ou TSPLIB), mantendo os
+// ids originais, e pré-calcular a matriz de distâncias entre eles
 void ler_coordenadas(const char *nome_arquivo, Point points[])
 {
-    FILE *arquivo = fopen(nome_arquivo, "r");
-    if (arquivo == NULL)
+    PROF_ESCOPO("leitura");
+    InstanciaTSP instancia;
+    ler_instancia(nome_arquivo, &instancia);
+    if (instancia.n < 5 || instancia.n > MAX_PONTOS)
     {
-        printf("Erro ao abrir o arquivo.\n");
+        fprintf(stderr, "O GA aceita de 5 a %d pontos; o arquivo tem %d\n", MAX_PONTOS, instancia.n);
         exit(1);
     }
-    int id;
-    double x, y, z;
+    n = instancia.n;
+    snprintf(nome_instancia, sizeof(nome_instancia), "%s", instancia.nome);
     for (int i = 0; i < n; i++)
     {
-        fscanf(arquivo, "%lf %lf %lf", &x, &y, &z);
-        points[i].id = i;
-        points[i].x = x;
-        points[i].y = y;
-        points[i].z = z;
+        points[i] = instancia.points[i];
     }
+    free(matriz);
+    matriz = calcular_matriz(&instancia, n);
+    tipo_peso = instancia.tipo;
+    liberar_instancia(&instancia);
+
     for (int i = 0; i < n; i++)
     {
         printf("ID: %d, X: %.6f, Y: %.6f, Z: %.6f\n", points[i].id, points[i].x, points[i].y, points[i].z);
     }
-    fclose(arquivo);
+}
+
+// Perturbação double-bridge: A B C D -> A C B D (o ponto de partida fica no lugar)
+void double_bridge(Individual *individual)
+{
+    int a = rand() % (n - 3) + 1;
+    int b = a + rand() % (n - a - 2) + 1;
+    int c = b + rand() % (n - b - 1) + 1;
+
+    int temp[n];
+    int k = 0;
+    for (int i = b; i < c; i++)
+        temp[k++] = individual->path[i];
+    for (int i = a; i < b; i++)
+        temp[k++] = individual->path[i];
+    memcpy(&individual->path[a], temp, k * sizeof(int));
+}
+
+// Reinicia a população a partir do melhor caminho já encontrado: ele é mantido
+// e os demais indivíduos são cópias dele perturbadas por double-bridge
+void restart_population(Individual population[], Individual incumbent, Point points[])
+{
+    PROF_ESCOPO("restart_population");
+    population[0] = incumbent;
+    for (int i = 1; i < pop_size; i++)
+    {
+        population[i] = incumbent;
+        double_bridge(&population[i]);
+        population[i].fitness = calculate_fitness(population[i], points);
+    }
 }
 
 // Função para calcular e imprimir a taxa de convergência
-double taxa_convergencai(double best_fitness[])
+double taxa_convergencai(double first_best, double last_best)
 {
-    return (best_fitness[iterations - 1] - best_fitness[0]) / best_fitness[0];
+    return (last_best - first_best) / first_best;
 }
 
-double ga()
+double ga(const Prazo *prazo)
 {
     // Carregar coordenadas do arquivo
-    const char *nome_arquivo = "..\\coordenadas\\star100.xyz.txt";
-    Point points[n];
-    ler_coordenadas(nome_arquivo, points);
+    Point points[MAX_PONTOS];
+    ler_coordenadas(arquivo_coordenadas, points);
 
     // Inicializar a população
     Individual population[pop_size];
     initialize_population(population, points);
 
-    // Array para armazenar o fitness do melhor indivíduo em cada geração
-    double best_fitness[iterations];
+    // Melhor caminho já encontrado (o GA não tem elitismo, então guardamos à parte)
+    Individual incumbent = find_best_individual(population);
+    double first_best = incumbent.fitness;
+    double last_best = incumbent.fitness;
+
+    int last_improvement = 0;
+    int restarts = 0;
+    double inicio_evolucao = relogio(); // O prazo já inclui a leitura; o ritmo conta só as gerações
 
     // Loop pricipal
-    for (int i = 0; i < iterations; i++)
+    for (int i = 0; prazo_ativo(prazo) ? !prazo_expirou(prazo) : i < iterations; i++)
     {
         if (evolve_population(population, points))
         {
@@ -295,7 +340,25 @@ double ga()
 
         // Encontrar o melhor indivíduo da geração atual
         Individual best_individual = find_best_individual(population);
-        best_fitness[i] = best_individual.fitness;
+        last_best = best_individual.fitness;
+        if (best_individual.fitness < incumbent.fitness)
+        {
+            incumbent = best_individual;
+            last_improvement = i;
+        }
+
+        // Estagnou: só reinicia se o prazo restante ainda comporta outra
+        // janela de stall_generations gerações no ritmo medido até aqui
+        if (prazo_ativo(prazo) && n > 4 && i - last_improvement >= stall_generations)
+        {
+            double per_generation = (relogio() - inicio_evolucao) / (i + 1);
+            if (prazo_restante(prazo) > stall_generations * per_generation)
+            {
+                restart_population(population, incumbent, points);
+                restarts++;
+            }
+            last_improvement = i;
+        }
 
         if (i % 1000 == 0)
         {
@@ -305,28 +368,46 @@ double ga()
             printf("Caminho:\n");
             for (int j = 0; j < n; j++)
             {
-                printf("%d ", best_individual.path[j]);
+                printf("%d ", points[best_individual.path[j]].id);
             }
             printf("\n");
         }
     }
 
-    // Encontrar o melhor indivíduo
+    // O melhor caminho é o incumbente ou algum indivíduo da população final
     Individual best_individual = find_best_individual(population);
+    if (incumbent.fitness < best_individual.fitness)
+    {
+        best_individual = incumbent;
+    }
+    if (prazo_ativo(prazo))
+    {
+        printf("Prazo de %.2f s atingido apos %d reinicios\n", time_limit, restarts);
+    }
 
     // Imprimir o melhor caminho encontrado
     printf("Melhor caminho encontrado:\n");
     for (int i = 0; i < n; i++)
     {
-        printf("%d ", best_individual.path[i]);
+        printf("%d ", points[best_individual.path[i]].id);
     }
     printf("\n");
 
     // Imprimir o comprimento do melhor caminho encontrado
     printf("Comprimento do melhor caminho: %.2f\n", best_individual.fitness);
 
+    if (arquivo_tour != NULL)
+    {
+        int ids[MAX_PONTOS];
+        for (int i = 0; i < n; i++)
+        {
+            ids[i] = points[best_individual.path[i]].id;
+        }
+        gravar_tour(arquivo_tour, nome_instancia, ids, n, best_individual.fitness);
+    }
+
     // Imprimir a taxa de convergência
-    return taxa_convergencai(best_fitness);
+    return taxa_convergencai(first_best, last_best);
 }
 
 void gravarLog(char msg[])
@@ -354,7 +435,9 @@ void gerarGrid(int popSizeMin, int popSizeMax, float mutationRateMin, float muta
         for (float j = mutationRateMin; j < mutationRateMax; j += 0.01)
         {
             mutation_rate = j;
-            double taxa = ga();
+            Prazo prazo;
+            prazo_iniciar(&prazo, time_limit);
+            double taxa = ga(&prazo);
             char msg[300];
             sprintf(msg, "[popSize:%d, mutationRate:%f] taxa de convergencia = %.6f\n", i, j, taxa);
 
@@ -374,10 +457,26 @@ void gerarGrid(int popSizeMin, int popSizeMax, float mutationRateMin, float muta
     gravarLog(msg_best);
 }
 
-int main()
+int main(int argc, char *argv[])
 {
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--time-limit") == 0 && i + 1 < argc)
+            time_limit = atof(argv[++i]);
+        else if (strcmp(argv[i], "--tour") == 0 && i + 1 < argc)
+            arquivo_tour = argv[++i];
+        else
+            arquivo_coordenadas = argv[i];
+    }
+
+    // O prazo conta desde o início do processo, incluindo a leitura
+    Prazo prazo;
+    prazo_iniciar(&prazo, time_limit);
+
     // gerarGrid(10, 150, 0.01, 0.10);
 
-    ga();
+    ga(&prazo);
+    PROF_RELATORIO(stdout);
+    free(matriz);
     return 0;
 }
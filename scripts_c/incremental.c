@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "incremental.h"
+
+// Atualiza um tour existente depois de uma mudança no catálogo.
+//
+//   incremental catalogo.xyz.txt caminho.tour delta.txt [delta2.txt ...] [--tour novo.tour] [--catalogo novo.xyz.txt]
+//
+// Vários deltas são aplicados em sequência sobre o mesmo estado (árvore k-d,
+// tour e buffers), como faria um processo que acompanha o catálogo ao vivo.
+//
+// O delta tem uma alteração por linha: "+ x y z" insere uma estrela e "- id"
+// remove a estrela com esse id; linhas vazias ou começando com '#' são ignoradas.
+// O catálogo novo é gravado no formato do original. Em TSPLIB (mesmo
+// EDGE_WEIGHT_TYPE) os ids são estáveis: os sobreviventes mantêm o seu e as
+// estrelas novas recebem maior id + 1. O .xyz.txt não tem coluna de id, então
+// ali o tour novo usa a posição no catálogo gravado (1..n).
+
+// Função para ler o delta de um arquivo
+void ler_delta(const char *nome_arquivo, DeltaCatalogo *delta)
+{
+    FILE *arquivo = fopen(nome_arquivo, "r");
+    if (arquivo == NULL)
+    {
+        perror("Erro ao abrir o delta");
+        exit(EXIT_FAILURE);
+    }
+
+    int cap_inseridos = 64, cap_removidos = 64;
+    Point *inseridos = malloc(cap_inseridos * sizeof(Point));
+    int *removidos = malloc(cap_removidos * sizeof(int));
+    delta->num_inseridos = 0;
+    delta->num_removidos = 0;
+
+    char linha[256];
+    int numero = 0;
+    while (fgets(linha, sizeof(linha), arquivo) != NULL)
+    {
+        numero++;
+        char *conteudo = aparar(linha);
+        if (*conteudo == '\0' || *conteudo == '#')
+            continue;
+
+        if (*conteudo == '+')
+        {
+            Point p = {0, 0.0, 0.0, 0.0};
+            if (sscanf(conteudo + 1, "%lf %lf %lf", &p.x, &p.y, &p.z) != 3)
+            {
+                fprintf(stderr, "Linha %d do delta invalida: %s\n", numero, conteudo);
+                exit(EXIT_FAILURE);
+            }
+            if (delta->num_inseridos == cap_inseridos)
+            {
+                cap_inseridos *= 2;
+                inseridos = realloc(inseridos, cap_inseridos * sizeof(Point));
+            }
+            inseridos[delta->num_inseridos++] = p;
+        }
+        else if (*conteudo == '-')
+        {
+            int id;
+            if (sscanf(conteudo + 1, "%d", &id) != 1)
+            {
+                fprintf(stderr, "Linha %d do delta invalida: %s\n", numero, conteudo);
+                exit(EXIT_FAILURE);
+            }
+            if (delta->num_removidos == cap_removidos)
+            {
+                cap_removidos *= 2;
+                removidos = realloc(removidos, cap_removidos * sizeof(int));
+            }
+            removidos[delta->num_removidos++] = id;
+        }
+        else
+        {
+            fprintf(stderr, "Linha %d do delta invalida: %s\n", numero, conteudo);
+            exit(EXIT_FAILURE);
+        }
+    }
+    fclose(arquivo);
+
+    delta->inseridos = inseridos;
+    delta->removidos = removidos;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *arquivos[2] = {NULL, NULL};
+    const char **deltas = malloc((argc > 1 ? argc : 1) * sizeof(char *));
+    const char *arquivo_tour = "incremental.tour";
+    const char *arquivo_catalogo = NULL;
+    int posicionais = 0, num_deltas = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--tour") == 0 && i + 1 < argc)
+            arquivo_tour = argv[++i];
+        else if (strcmp(argv[i], "--catalogo") == 0 && i + 1 < argc)
+            arquivo_catalogo = argv[++i];
+        else if (posicionais < 2)
+            arquivos[posicionais++] = argv[i];
+        else
+            deltas[num_deltas++] = argv[i];
+    }
+    if (num_deltas == 0)
+    {
+        fprintf(stderr, "Uso: %s catalogo tour delta [delta ...] [--tour novo.tour] [--catalogo novo.xyz.txt]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    InstanciaTSP inst;
+    ler_instancia(arquivos[0], &inst);
+
+    // O tour referencia as estrelas pelo id; convertê-lo para índices
+    int tamanho_tour;
+    int *ids = ler_tour(arquivos[1], &tamanho_tour);
+    if (tamanho_tour != inst.n)
+    {
+        fprintf(stderr, "O tour tem %d pontos, mas o catalogo tem %d\n", tamanho_tour, inst.n);
+        return EXIT_FAILURE;
+    }
+    int max_id = 0;
+    for (int i = 0; i < inst.n; i++)
+    {
+        if (inst.points[i].id > max_id)
+            max_id = inst.points[i].id;
+    }
+    int *indice_id = malloc((max_id + 1) * sizeof(int));
+    for (int id = 0; id <= max_id; id++)
+        indice_id[id] = -1;
+    for (int i = 0; i < inst.n; i++)
+        indice_id[inst.points[i].id] = i;
+    int *tour = malloc(inst.n * sizeof(int));
+    bool *visto = calloc(inst.n > 0 ? inst.n : 1, sizeof(bool));
+    for (int i = 0; i < inst.n; i++)
+    {
+        if (ids[i] < 0 || ids[i] > max_id || indice_id[ids[i]] < 0)
+        {
+            fprintf(stderr, "Id %d do tour nao existe no catalogo\n", ids[i]);
+            return EXIT_FAILURE;
+        }
+        tour[i] = indice_id[ids[i]];
+        if (visto[tour[i]])
+        {
+            fprintf(stderr, "Id %d aparece mais de uma vez no tour\n", ids[i]);
+            return EXIT_FAILURE;
+        }
+        visto[tour[i]] = true;
+    }
+    free(ids);
+    free(indice_id);
+    free(visto);
+
+    double comprimento_antes = 0.0;
+    for (int i = 0; i < inst.n; i++)
+    {
+        comprimento_antes += peso_tsplib(inst.tipo, &inst.points[tour[i]], &inst.points[tour[(i + 1) % inst.n]]);
+    }
+    printf("Comprimento inicial: %.6f\n", comprimento_antes);
+
+    // A árvore k-d e os buffers são montados uma vez e servem a todos os deltas
+    double inicio = relogio();
+    CatalogoIncremental cat;
+    iniciar_catalogo(&cat, &inst, tour);
+    free(tour);
+    printf("Indice do catalogo: %.3f ms\n", (relogio() - inicio) * 1000.0);
+
+    double comprimento = comprimento_antes;
+    for (int d = 0; d < num_deltas; d++)
+    {
+        DeltaCatalogo delta;
+        ler_delta(deltas[d], &delta);
+
+        ResultadoIncremental res;
+        atualizar_tour(&cat, &delta, &res);
+        comprimento = res.comprimento;
+
+        printf("%s: removidas %d, inseridas %d, pontos no tour %d\n", deltas[d], res.removidos, res.inseridos, cat.vivos);
+        printf("  Busca local: %d pontos tocados, %ld movimentos 2-opt\n", res.tocados, res.movimentos);
+        printf("  Comprimento: %.6f, tempo da atualizacao: %.3f ms%s\n", res.comprimento, res.tempo * 1000.0,
+               res.reindexado ? " (arvore reconstruida)" : "");
+        free((Point *)delta.inseridos);
+        free((int *)delta.removidos);
+    }
+
+    // Gravar o catálogo novo (estrelas vivas, na ordem dos slots) e o tour com a numeração dele
+    InstanciaTSP saida = cat.inst;
+    saida.n = cat.vivos;
+    saida.points = alocar_pontos(cat.vivos);
+    int *linha = malloc((cat.inst.n > 0 ? cat.inst.n : 1) * sizeof(int));
+    for (int s = 0, k = 0; s < cat.inst.n; s++)
+    {
+        if (cat.vivo[s])
+        {
+            linha[s] = k + 1;
+            saida.points[k++] = cat.inst.points[s];
+        }
+    }
+    bool xyz = saida.tipo == PESO_EUCLIDIANO;
+    if (xyz)
+        gravar_xyz(arquivo_catalogo != NULL ? arquivo_catalogo : "incremental.xyz.txt", saida.points, saida.n);
+    else
+        gravar_tsplib(arquivo_catalogo != NULL ? arquivo_catalogo : "incremental.tsp", &saida);
+    int *novo_tour = malloc((cat.vivos > 0 ? cat.vivos : 1) * sizeof(int));
+    for (int i = 0; i < cat.vivos; i++)
+    {
+        int s = cat.tour[i];
+        novo_tour[i] = xyz ? linha[s] : cat.inst.points[s].id;
+    }
+    gravar_tour(arquivo_tour, saida.nome, novo_tour, saida.n, comprimento);
+
+    PROF_RELATORIO(stdout);
+
+    free(novo_tour);
+    free(linha);
+    free(deltas);
+    liberar_instancia(&saida);
+    liberar_catalogo(&cat);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,426 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "tsplib.h"
+#include "prazo.h"
+#include "kdtree.h"
+#include "busca_local.h"
+#include "profiling.h"
+
+// Atualização incremental de um tour quando o catálogo muda: as estrelas
+// removidas saem do tour, as novas entram por inserção mais barata (candidatas
+// vindas da árvore k-d) e a busca local 2-opt roda só a partir dos pontos
+// tocados, em vez de reler o arquivo e resolver tudo de novo.
+//
+// O estado (CatalogoIncremental) vive entre atualizações: a árvore k-d do
+// catálogo é construída uma vez, as estrelas novas ficam numa árvore auxiliar
+// pequena e as removidas só são marcadas. A árvore principal só é refeita
+// quando as mudanças acumuladas passam dos limites abaixo.
+
+#define K_INSERCAO 8          // Pontos do tour mais próximos avaliados ao inserir uma estrela
+#define LIMITE_RECENTES 4096  // Estrelas novas fora da árvore principal antes de reconstruí-la
+#define FRACAO_REMOVIDAS 8    // Reconstrói também quando 1/8 dos slots são estrelas removidas
+#ifndef MAX_INVERSAO
+#define MAX_INVERSAO 1000     // Trecho máximo invertido por movimento 2-opt (o array tem o catálogo todo)
+#endif
+
+typedef struct
+{
+    int num_inseridos;
+    const Point *inseridos; // Coordenadas das estrelas novas (o id é atribuído aqui)
+    int num_removidos;
+    const int *removidos;   // Ids das estrelas que saíram do catálogo
+} DeltaCatalogo;
+
+typedef struct
+{
+    int removidos;      // Ids do delta encontrados no catálogo
+    int inseridos;
+    int tocados;        // Pontos que entraram na fila da busca local
+    long movimentos;    // Movimentos 2-opt aplicados
+    bool reindexado;    // Se a árvore principal foi reconstruída nesta atualização
+    double comprimento; // Comprimento do tour atualizado
+    double tempo;       // Segundos gastos em atualizar_tour
+} ResultadoIncremental;
+
+// Cada estrela ocupa um slot de inst.points. As removidas continuam no slot,
+// com vivo[slot] = false, até a próxima reconstrução, que compacta os slots.
+// A árvore principal cobre os slots [0, base) e a auxiliar, refeita a cada
+// atualização, as estrelas novas [base, inst.n).
+typedef struct
+{
+    InstanciaTSP inst; // inst.n = slots em uso, incluindo removidas
+    int capacidade;
+    int vivos;         // Estrelas no catálogo (e no tour)
+    int removidas;     // Slots de estrelas removidas ainda não compactados
+    bool *vivo;
+    ArvoreKd principal;
+    ArvoreKd recentes;
+    int base;
+    int *indice_id;    // Id -> slot, ou -1
+    int cap_ids;
+    int max_id;
+    int *tour;         // Slots na ordem do tour (vivos posições)
+    int *pos;          // Posição de cada slot em 'tour'
+    int *tour_aux;     // Buffers reaproveitados entre atualizações
+    int *fila;
+    bool *na_fila;
+    int *suc_extra;    // Ligações criadas pelas inserções, por cima de 'tour' (-1 = nenhuma)
+    int *pred_extra;
+    Instancia local;   // Listas de candidatos preguiçosas, por slot
+    double soma;       // Comprimento do tour em custo_t, mantido a cada mudança
+} CatalogoIncremental;
+
+static inline void *crescer_buffer(void *buffer, size_t bytes)
+{
+    void *novo = realloc(buffer, bytes > 0 ? bytes : 1);
+    if (novo == NULL)
+    {
+        perror("Erro ao alocar memória");
+        exit(EXIT_FAILURE);
+    }
+    return novo;
+}
+
+// Garante espaço para 'slots' estrelas em todos os vetores por slot
+static inline void reservar_slots(CatalogoIncremental *cat, int slots)
+{
+    if (slots <= cat->capacidade)
+        return;
+    int antiga = cat->capacidade;
+    int cap = antiga * 2 > slots ? antiga * 2 : slots;
+
+    cat->inst.points = crescer_buffer(cat->inst.points, cap * sizeof(Point));
+    cat->vivo = crescer_buffer(cat->vivo, cap * sizeof(bool));
+    cat->tour = crescer_buffer(cat->tour, cap * sizeof(int));
+    cat->pos = crescer_buffer(cat->pos, cap * sizeof(int));
+    cat->tour_aux = crescer_buffer(cat->tour_aux, cap * sizeof(int));
+    cat->fila = crescer_buffer(cat->fila, cap * sizeof(int));
+    cat->na_fila = crescer_buffer(cat->na_fila, cap * sizeof(bool));
+    cat->suc_extra = crescer_buffer(cat->suc_extra, cap * sizeof(int));
+    cat->pred_extra = crescer_buffer(cat->pred_extra, cap * sizeof(int));
+    cat->local.vizinhos = crescer_buffer(cat->local.vizinhos, (size_t)cap * K_VIZINHOS * sizeof(int));
+    cat->local.custos = crescer_buffer(cat->local.custos, (size_t)cap * K_VIZINHOS * sizeof(custo_t));
+    cat->local.prontos = crescer_buffer(cat->local.prontos, cap);
+    for (int s = antiga; s < cap; s++)
+    {
+        cat->vivo[s] = false;
+        cat->na_fila[s] = false;
+        cat->suc_extra[s] = -1;
+        cat->pred_extra[s] = -1;
+        cat->local.prontos[s] = 0;
+    }
+    cat->capacidade = cap;
+
+    // As árvores e as listas apontam para os pontos, que podem ter mudado de lugar
+    cat->principal.points = cat->inst.points;
+    cat->recentes.points = cat->inst.points + cat->base;
+    cat->local.points = cat->inst.points;
+    cat->local.vivo = cat->vivo;
+}
+
+static inline void registrar_id(CatalogoIncremental *cat, int id, int slot)
+{
+    if (id >= cat->cap_ids)
+    {
+        int cap = cat->cap_ids * 2 > id + 1 ? cat->cap_ids * 2 : id + 1;
+        cat->indice_id = crescer_buffer(cat->indice_id, cap * sizeof(int));
+        for (int i = cat->cap_ids; i < cap; i++)
+            cat->indice_id[i] = -1;
+        cat->cap_ids = cap;
+    }
+    cat->indice_id[id] = slot;
+    if (id > cat->max_id)
+        cat->max_id = id;
+}
+
+// Compacta os slots (tira as removidas) e reconstrói a árvore principal com
+// todas as estrelas; as listas de candidatos voltam a ser calculadas sob demanda
+static inline void reindexar_catalogo(CatalogoIncremental *cat)
+{
+    PROF_ESCOPO("reindexar_catalogo");
+    int *novo_slot = cat->tour_aux;
+    int usados = cat->inst.n, k = 0;
+    for (int s = 0; s < usados; s++)
+    {
+        novo_slot[s] = cat->vivo[s] ? k : -1;
+        if (cat->vivo[s])
+            cat->inst.points[k++] = cat->inst.points[s];
+    }
+    for (int i = 0; i < cat->vivos; i++)
+    {
+        cat->tour[i] = novo_slot[cat->tour[i]];
+        cat->pos[cat->tour[i]] = i;
+    }
+    for (int s = 0; s < usados; s++)
+    {
+        cat->vivo[s] = s < k;
+        cat->local.prontos[s] = 0;
+    }
+    for (int s = 0; s < k; s++)
+        cat->indice_id[cat->inst.points[s].id] = s;
+    cat->inst.n = k;
+    cat->removidas = 0;
+
+    liberar_arvore(&cat->principal);
+    liberar_arvore(&cat->recentes);
+    construir_arvore(&cat->principal, cat->inst.points, k);
+    construir_arvore(&cat->recentes, cat->inst.points + k, 0);
+    cat->base = k;
+    cat->local.base_recentes = k;
+}
+
+// Assume a instância (inst->points passa a pertencer ao catálogo) e o tour
+// inicial, em índices de inst->points; constrói a árvore principal
+static inline void iniciar_catalogo(CatalogoIncremental *cat, InstanciaTSP *inst, const int *tour)
+{
+    memset(cat, 0, sizeof(*cat));
+    cat->inst = *inst;
+    inst->points = NULL;
+    inst->n = 0;
+
+    int n = cat->inst.n;
+    cat->local.k = K_VIZINHOS;
+    cat->local.tipo = cat->inst.tipo;
+    cat->local.arvore = &cat->principal;
+    cat->local.recentes = &cat->recentes;
+    cat->local.max_inversao = MAX_INVERSAO;
+    reservar_slots(cat, n > 0 ? n : 1);
+
+    cat->vivos = n;
+    for (int s = 0; s < n; s++)
+    {
+        cat->vivo[s] = true;
+        registrar_id(cat, cat->inst.points[s].id, s);
+        cat->tour[s] = tour[s];
+        cat->pos[tour[s]] = s;
+    }
+    cat->local.n = n;
+    reindexar_catalogo(cat);
+    cat->soma = 0.0;
+    for (int i = 0; i < n; i++)
+        cat->soma += dist_ij(&cat->local, cat->tour[i], cat->tour[(i + 1) % n]);
+}
+
+static inline void liberar_catalogo(CatalogoIncremental *cat)
+{
+    liberar_arvore(&cat->principal);
+    liberar_arvore(&cat->recentes);
+    liberar_instancia(&cat->inst);
+    free(cat->vivo);
+    free(cat->indice_id);
+    free(cat->tour);
+    free(cat->pos);
+    free(cat->tour_aux);
+    free(cat->fila);
+    free(cat->na_fila);
+    free(cat->suc_extra);
+    free(cat->pred_extra);
+    free(cat->local.vizinhos);
+    free(cat->local.custos);
+    free(cat->local.prontos);
+}
+
+// Vizinhos de v no tour em montagem: a ligação criada por uma inserção, ou o
+// slot vivo seguinte (anterior) no tour antigo, de 'tam' posições
+static inline int sucessor_montagem(const CatalogoIncremental *cat, int v, int tam)
+{
+    if (cat->suc_extra[v] >= 0)
+        return cat->suc_extra[v];
+    int p = cat->pos[v];
+    do
+        p = p + 1 == tam ? 0 : p + 1;
+    while (!cat->vivo[cat->tour[p]]);
+    return cat->tour[p];
+}
+
+static inline int predecessor_montagem(const CatalogoIncremental *cat, int v, int tam)
+{
+    if (cat->pred_extra[v] >= 0)
+        return cat->pred_extra[v];
+    int p = cat->pos[v];
+    do
+        p = p == 0 ? tam - 1 : p - 1;
+    while (!cat->vivo[cat->tour[p]]);
+    return cat->tour[p];
+}
+
+// Aplica o delta ao catálogo e ao tour. As estrelas novas recebem ids a partir
+// do maior id já visto + 1. O custo depende do tamanho do delta e da região que
+// a busca local percorre; o único trabalho O(n) é um passe linear para remontar
+// o array do tour. De tempos em tempos a árvore principal é refeita
+// (res->reindexado), num custo amortizado entre as atualizações.
+static inline void atualizar_tour(CatalogoIncremental *cat, const DeltaCatalogo *delta, ResultadoIncremental *res)
+{
+    PROF_ESCOPO("atualizar_tour");
+    double inicio = relogio();
+    memset(res, 0, sizeof(*res));
+    int tam_antigo = cat->vivos;
+
+    int *mortas = malloc((delta->num_removidos > 0 ? delta->num_removidos : 1) * sizeof(int));
+    int *tocados = malloc((2 * delta->num_removidos + 3 * delta->num_inseridos + 1) * sizeof(int));
+    int num_tocados = 0;
+
+    // Remoções: a estrela só é marcada; o slot é compactado na reconstrução
+    for (int r = 0; r < delta->num_removidos; r++)
+    {
+        int id = delta->removidos[r];
+        if (id < 0 || id >= cat->cap_ids || cat->indice_id[id] < 0)
+            continue;
+        int s = cat->indice_id[id];
+        cat->indice_id[id] = -1;
+        cat->vivo[s] = false;
+        mortas[res->removidos++] = s;
+    }
+    cat->vivos -= res->removidos;
+    cat->removidas += res->removidos;
+    int vivos_antigos = cat->vivos;
+
+    // As pontas de cada lacuna viram uma aresta nova e entram na fila da busca
+    // local; o comprimento troca as arestas da lacuna pela aresta nova
+    if (vivos_antigos > 1)
+    {
+        for (int r = 0; r < res->removidos; r++)
+        {
+            int a = predecessor_montagem(cat, mortas[r], tam_antigo);
+            int b = sucessor_montagem(cat, mortas[r], tam_antigo);
+            tocados[num_tocados++] = a;
+            tocados[num_tocados++] = b;
+            if (cat->tour[cat->pos[mortas[r]] == 0 ? tam_antigo - 1 : cat->pos[mortas[r]] - 1] != a)
+                continue; // A lacuna é contada uma vez, a partir da primeira removida
+            for (int p = cat->pos[a], v = a; v != b;)
+            {
+                p = p + 1 == tam_antigo ? 0 : p + 1;
+                cat->soma -= dist_ij(&cat->local, v, cat->tour[p]);
+                v = cat->tour[p];
+            }
+            cat->soma += dist_ij(&cat->local, a, b);
+        }
+    }
+    else
+    {
+        cat->soma = 0.0;
+    }
+
+    // Estrelas novas em slots no fim; só entram nas consultas (vivo) depois de inseridas
+    int primeiro_novo = cat->inst.n;
+    reservar_slots(cat, cat->inst.n + delta->num_inseridos);
+    for (int j = 0; j < delta->num_inseridos; j++)
+    {
+        int q = cat->inst.n++;
+        cat->inst.points[q] = delta->inseridos[j];
+        cat->inst.points[q].id = cat->max_id + 1;
+        registrar_id(cat, cat->max_id + 1, q);
+    }
+    if (delta->num_inseridos > 0)
+    {
+        liberar_arvore(&cat->recentes);
+        construir_arvore(&cat->recentes, cat->inst.points + cat->base, cat->inst.n - cat->base);
+    }
+    res->inseridos = delta->num_inseridos;
+
+    // Inserção mais barata: só as arestas vizinhas dos K_INSERCAO pontos do
+    // tour mais próximos da estrela nova são avaliadas. A mesma consulta diz
+    // quais listas de candidatos devem ser recalculadas para incluí-la; as que
+    // ainda citam estrelas removidas servem, pois a busca local as ignora.
+    int ids[K_VIZINHOS];
+    double d2[K_VIZINHOS];
+    const Point *points = cat->inst.points;
+    for (int q = primeiro_novo; q < cat->inst.n; q++)
+    {
+        if (cat->vivos == 0)
+        {
+            cat->suc_extra[q] = cat->pred_extra[q] = q;
+        }
+        else
+        {
+            Melhores candidatos = {K_VIZINHOS, 0, ids, d2};
+            int total = buscar_candidatos(&cat->local, &points[q], q, &candidatos);
+            int melhor_a = -1, melhor_b = -1;
+            double melhor_custo = INFINITY;
+            for (int c = 0; c < total; c++)
+                cat->local.prontos[ids[c]] = 0;
+            for (int c = 0; c < total && c < K_INSERCAO; c++)
+            {
+                int pontas[2] = {ids[c], predecessor_montagem(cat, ids[c], tam_antigo)}; // (c, suc c) e (pred c, c)
+                for (int e = 0; e < 2; e++)
+                {
+                    int a = pontas[e], b = sucessor_montagem(cat, a, tam_antigo);
+                    double custo = peso_tsplib(cat->inst.tipo, &points[a], &points[q]) +
+                                   peso_tsplib(cat->inst.tipo, &points[q], &points[b]) -
+                                   peso_tsplib(cat->inst.tipo, &points[a], &points[b]);
+                    if (custo < melhor_custo)
+                    {
+                        melhor_custo = custo;
+                        melhor_a = a;
+                        melhor_b = b;
+                    }
+                }
+            }
+            int a = melhor_a, b = melhor_b;
+            cat->soma += dist_ij(&cat->local, a, q) + dist_ij(&cat->local, q, b) - dist_ij(&cat->local, a, b);
+            cat->suc_extra[a] = q;
+            cat->pred_extra[q] = a;
+            cat->suc_extra[q] = b;
+            cat->pred_extra[b] = q;
+            tocados[num_tocados++] = a;
+            tocados[num_tocados++] = q;
+            tocados[num_tocados++] = b;
+        }
+        cat->vivo[q] = true;
+        cat->vivos++;
+    }
+
+    // Remontar o array do tour num passe sequencial pelo antigo: cada
+    // sobrevivente seguido da corrente de estrelas inseridas depois dele
+    if (vivos_antigos > 0)
+    {
+        for (int p = 0, k = 0; p < tam_antigo; p++)
+        {
+            int v = cat->tour[p];
+            if (!cat->vivo[v])
+                continue;
+            cat->tour_aux[k++] = v;
+            for (int w = cat->suc_extra[v]; w >= primeiro_novo; w = cat->suc_extra[w])
+                cat->tour_aux[k++] = w;
+        }
+    }
+    else
+    {
+        for (int i = 0, v = primeiro_novo; i < cat->vivos; i++, v = cat->suc_extra[v])
+            cat->tour_aux[i] = v;
+    }
+    int *temp = cat->tour;
+    cat->tour = cat->tour_aux;
+    cat->tour_aux = temp;
+    for (int i = 0; i < cat->vivos; i++)
+        cat->pos[cat->tour[i]] = i;
+    for (int t = 0; t < num_tocados; t++)
+        cat->suc_extra[tocados[t]] = cat->pred_extra[tocados[t]] = -1;
+    for (int q = primeiro_novo; q < cat->inst.n; q++)
+        cat->suc_extra[q] = cat->pred_extra[q] = -1;
+
+    // 2-opt só a partir da região tocada, com os buffers do catálogo
+    cat->local.n = cat->vivos;
+    double ganho = 0.0;
+    res->tocados = num_tocados;
+    res->movimentos = busca_local_em(&cat->local, cat->tour, cat->vivos, cat->pos, cat->fila, cat->na_fila,
+                                     tocados, num_tocados, NULL, &ganho);
+    cat->soma -= ganho;
+    free(mortas);
+    free(tocados);
+
+    if (cat->inst.n - cat->base > LIMITE_RECENTES || cat->removidas * FRACAO_REMOVIDAS > cat->inst.n)
+    {
+        reindexar_catalogo(cat);
+        res->reindexado = true;
+    }
+    res->comprimento = custo_real(cat->inst.tipo, cat->soma);
+    res->tempo = relogio() - inicio;
+}
+
+#endif
@@ -0,0 +1,267 @@
+#ifndef KDTREE_H
+#define KDTREE_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include "tsplib.h"
+#include "profiling.h"
+
+// Árvore k-d usada nas listas de candidatos e na inserção incremental
+
+// Árvore k-d implícita: o nó de [lo, hi) é o índice do meio, com o eixo de corte em 'eixo'
+typedef struct
+{
+    int n;
+    const Point *points;
+    int *idx;
+    int *posicao; // Posição de cada ponto em idx
+    unsigned char *eixo;
+} ArvoreKd;
+
+// Os K melhores candidatos de uma consulta, em ordem crescente de distância
+typedef struct
+{
+    int k;
+    int total;
+    int *ids;
+    double *d2;
+} Melhores;
+
+static inline double coordenada(const Point *p, int eixo)
+{
+    return eixo == 0 ? p->x : (eixo == 1 ? p->y : p->z);
+}
+
+// Seleção parcial (quickselect): deixa em idx[k] o ponto de posição k no eixo dado
+static inline void selecionar(const Point *points, int *idx, int lo, int hi, int k, int eixo)
+{
+    while (hi - lo > 1)
+    {
+        double pivo = coordenada(&points[idx[(lo + hi) / 2]], eixo);
+        int i = lo, j = hi - 1;
+        while (i <= j)
+        {
+            while (coordenada(&points[idx[i]], eixo) < pivo)
+                i++;
+            while (coordenada(&points[idx[j]], eixo) > pivo)
+                j--;
+            if (i <= j)
+            {
+                int temp = idx[i];
+                idx[i] = idx[j];
+                idx[j] = temp;
+                i++;
+                j--;
+            }
+        }
+        if (k <= j)
+            hi = j + 1;
+        else if (k >= i)
+            lo = i;
+        else
+            return;
+    }
+}
+
+static inline void construir_no(ArvoreKd *arvore, int lo, int hi)
+{
+    if (hi - lo <= 0)
+        return;
+    int meio = (lo + hi) / 2;
+
+    // Cortar no eixo de maior espalhamento
+    double min[3] = {INFINITY, INFINITY, INFINITY};
+    double max[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (int i = lo; i < hi; i++)
+    {
+        const Point *p = &arvore->points[arvore->idx[i]];
+        for (int e = 0; e < 3; e++)
+        {
+            double c = coordenada(p, e);
+            if (c < min[e])
+                min[e] = c;
+            if (c > max[e])
+                max[e] = c;
+        }
+    }
+    int eixo = 0;
+    for (int e = 1; e < 3; e++)
+    {
+        if (max[e] - min[e] > max[eixo] - min[eixo])
+            eixo = e;
+    }
+
+    selecionar(arvore->points, arvore->idx, lo, hi, meio, eixo);
+    arvore->eixo[meio] = (unsigned char)eixo;
+    construir_no(arvore, lo, meio);
+    construir_no(arvore, meio + 1, hi);
+}
+
+static inline void construir_arvore(ArvoreKd *arvore, const Point *points, int n)
+{
+    PROF_ESCOPO("arvore_kd");
+    arvore->n = n;
+    arvore->points = points;
+    arvore->idx = malloc(n * sizeof(int));
+    arvore->eixo = malloc(n);
+    for (int i = 0; i < n; i++)
+    {
+        arvore->idx[i] = i;
+    }
+    construir_no(arvore, 0, n);
+    arvore->posicao = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++)
+    {
+        arvore->posicao[arvore->idx[i]] = i;
+    }
+}
+
+static inline void liberar_arvore(ArvoreKd *arvore)
+{
+    free(arvore->idx);
+    free(arvore->posicao);
+    free(arvore->eixo);
+}
+
+static inline void considerar_candidato(Melhores *m, int id, double d2)
+{
+    if (m->total == m->k && d2 >= m->d2[m->total - 1])
+        return;
+    int i = m->total < m->k ? m->total++ : m->total - 1;
+    while (i > 0 && m->d2[i - 1] > d2)
+    {
+        m->ids[i] = m->ids[i - 1];
+        m->d2[i] = m->d2[i - 1];
+        i--;
+    }
+    m->ids[i] = id;
+    m->d2[i] = d2;
+}
+
+// Busca recursiva; com 'no_filtro' != NULL só pontos marcados entram como candidatos
+static inline void buscar_no(const ArvoreKd *arvore, int lo, int hi, const Point *q, int excluir,
+                             const bool *no_filtro, Melhores *m)
+{
+    if (hi - lo <= 0)
+        return;
+    int meio = (lo + hi) / 2;
+    int p = arvore->idx[meio];
+    const Point *ponto = &arvore->points[p];
+    if (p != excluir && (no_filtro == NULL || no_filtro[p]))
+    {
+        double dx = q->x - ponto->x, dy = q->y - ponto->y, dz = q->z - ponto->z;
+        considerar_candidato(m, p, dx * dx + dy * dy + dz * dz);
+    }
+
+    int eixo = arvore->eixo[meio];
+    double diff = coordenada(q, eixo) - coordenada(ponto, eixo);
+    if (diff < 0)
+    {
+        buscar_no(arvore, lo, meio, q, excluir, no_filtro, m);
+        if (m->total < m->k || diff * diff < m->d2[m->total - 1])
+            buscar_no(arvore, meio + 1, hi, q, excluir, no_filtro, m);
+    }
+    else
+    {
+        buscar_no(arvore, meio + 1, hi, q, excluir, no_filtro, m);
+        if (m->total < m->k || diff * diff < m->d2[m->total - 1])
+            buscar_no(arvore, lo, meio, q, excluir, no_filtro, m);
+    }
+}
+
+// Os m->k pontos mais próximos de q (exceto 'excluir'); retorna quantos achou
+static inline int buscar_vizinhos(const ArvoreKd *arvore, const Point *q, int excluir, const bool *no_filtro, Melhores *m)
+{
+    m->total = 0;
+    buscar_no(arvore, 0, arvore->n, q, excluir, no_filtro, m);
+    return m->total;
+}
+
+// Pontos livres por subárvore: livres[meio] conta os pontos ainda disponíveis
+// no nó [lo, hi). Serve às construções gulosas, que retiram um ponto por passo
+// e precisam do livre mais próximo sem varrer os já visitados.
+static inline void iniciar_livres_no(int *livres, int lo, int hi)
+{
+    if (hi - lo <= 0)
+        return;
+    int meio = (lo + hi) / 2;
+    livres[meio] = hi - lo;
+    iniciar_livres_no(livres, lo, meio);
+    iniciar_livres_no(livres, meio + 1, hi);
+}
+
+static inline void iniciar_livres(const ArvoreKd *arvore, int *livres)
+{
+    iniciar_livres_no(livres, 0, arvore->n);
+}
+
+static inline int contar_livres(const int *livres, int lo, int hi)
+{
+    return hi - lo <= 0 ? 0 : livres[(lo + hi) / 2];
+}
+
+// Retira o ponto p, descontando-o de todos os nós no caminho até ele
+static inline void retirar_livre(const ArvoreKd *arvore, int *livres, int p)
+{
+    int alvo = arvore->posicao[p];
+    int lo = 0, hi = arvore->n;
+    while (hi - lo > 0)
+    {
+        int meio = (lo + hi) / 2;
+        livres[meio]--;
+        if (alvo == meio)
+            return;
+        if (alvo < meio)
+            hi = meio;
+        else
+            lo = meio + 1;
+    }
+}
+
+// Busca recursiva que poda subárvores sem pontos livres
+static inline void buscar_livre_no(const ArvoreKd *arvore, const int *livres, int lo, int hi, const Point *q,
+                                   int *melhor, double *melhor_d2)
+{
+    if (contar_livres(livres, lo, hi) == 0)
+        return;
+    int meio = (lo + hi) / 2;
+    int p = arvore->idx[meio];
+    const Point *ponto = &arvore->points[p];
+    if (livres[meio] - contar_livres(livres, lo, meio) - contar_livres(livres, meio + 1, hi) == 1)
+    {
+        double dx = q->x - ponto->x, dy = q->y - ponto->y, dz = q->z - ponto->z;
+        double d2 = dx * dx + dy * dy + dz * dz;
+        if (d2 < *melhor_d2)
+        {
+            *melhor_d2 = d2;
+            *melhor = p;
+        }
+    }
+
+    int eixo = arvore->eixo[meio];
+    double diff = coordenada(q, eixo) - coordenada(ponto, eixo);
+    if (diff < 0)
+    {
+        buscar_livre_no(arvore, livres, lo, meio, q, melhor, melhor_d2);
+        if (diff * diff < *melhor_d2)
+            buscar_livre_no(arvore, livres, meio + 1, hi, q, melhor, melhor_d2);
+    }
+    else
+    {
+        buscar_livre_no(arvore, livres, meio + 1, hi, q, melhor, melhor_d2);
+        if (diff * diff < *melhor_d2)
+            buscar_livre_no(arvore, livres, lo, meio, q, melhor, melhor_d2);
+    }
+}
+
+// O ponto livre mais próximo de q (distância euclidiana), ou -1 se não houver
+static inline int buscar_livre(const ArvoreKd *arvore, const int *livres, const Point *q)
+{
+    int melhor = -1;
+    double melhor_d2 = INFINITY;
+    buscar_livre_no(arvore, livres, 0, arvore->n, q, &melhor, &melhor_d2);
+    return melhor;
+}
+
+#endif
@@ -1,23 +1,25 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <math.h> // Para utilizar as funções sqrt() e pow()
+#include "tsplib.h"
+#include "prazo.h"
+#include "profiling.h"
 
-// Estrutura para representar uma coordenada
-typedef struct
-{
-    int id;
-    float x;
-    float y;
-    float z;
-} CoordenadaEstrela;
+// Representação das estrelas e leitura dos arquivos ficam em tsplib.h
+typedef Point CoordenadaEstrela;
+
+// Regra de distância da instância lida (EUC_3D, ATT, ... ou euclidiana real)
+TipoPeso tipoDistancia = PESO_EUCLIDIANO;
+
+// --time-limit: ao expirar, o caminho é completado com os pontos restantes na ordem do arquivo.
+// O prazo começa no início do main, então a leitura e a impressão também contam.
 
 // Função para calcular a distância entre dois pontos em 3D
 float calcularDistancia(CoordenadaEstrela ponto1, CoordenadaEstrela ponto2)
 {
-    float distancia;
-    distancia = sqrt(pow(ponto2.x - ponto1.x, 2) + pow(ponto2.y - ponto1.y, 2) + pow(ponto2.z - ponto1.z, 2));
-    return distancia;
+    return peso_tsplib(tipoDistancia, &ponto1, &ponto2);
 }
 
 // Função para percorrer o vetor de coordenadas e calcular a distância total entre estrelas consecutivas
@@ -36,6 +38,7 @@ float calcularDistanciaTotal(CoordenadaEstrela *coordenadas, int tamanho)
 // Função para encontrar o próximo ponto mais próximo não visitado
 int encontrarProximoPontoMaisProximo(CoordenadaEstrela *coordenadas, bool *visitado, int pontoAtual, int tamanho)
 {
+    PROF_ESCOPO("busca_proximo");
     int proximoPonto = -1;
     float menorDistancia = INFINITY;
 
@@ -57,8 +60,10 @@ int encontrarProximoPontoMaisProximo(CoordenadaEstrela *coordenadas, bool *visit
 
 // ALGORITMO GULOSO
 // Função para encontrar a rota usando o algoritmo guloso
-void algoritmoGulosoVizinhoMaisProximo(CoordenadaEstrela *coordenadas, int tamanho, int *caminho, float *distanciaTotal)
+void algoritmoGulosoVizinhoMaisProximo(CoordenadaEstrela *coordenadas, int tamanho, int *caminho, float *distanciaTotal,
+                                       const Prazo *prazo)
 {
+    PROF_ESCOPO("vizinho_mais_proximo");
     bool *visitado = (bool *)calloc(tamanho, sizeof(bool));
     int pontoAtual = 0;
 
@@ -69,88 +74,82 @@ void algoritmoGulosoVizinhoMaisProximo(CoordenadaEstrela *coordenadas, int taman
 
     int contadorPontos = 0;
 
+    int proximoLivre = 0; // Usado para completar o caminho quando o prazo expira
+
     for (int i = 1; i < tamanho; i++)
     {
-        int proximoPonto = encontrarProximoPontoMaisProximo(coordenadas, visitado, pontoAtual, tamanho);
+        int proximoPonto;
+        if (prazo_expirou(prazo))
+        {
+            while (visitado[proximoLivre])
+                proximoLivre++;
+            proximoPonto = proximoLivre;
+        }
+        else
+        {
+            proximoPonto = encontrarProximoPontoMaisProximo(coordenadas, visitado, pontoAtual, tamanho);
+        }
         caminho[i] = coordenadas[proximoPonto].id;
         *distanciaTotal += calcularDistancia(coordenadas[pontoAtual], coordenadas[proximoPonto]);
         visitado[proximoPonto] = true;
         pontoAtual = proximoPonto; // Atualizando o ponto atual para o próximo ponto selecionado
         contadorPontos++;
-        printf("Pontos passados: %i \n", contadorPontos);
+        if (!prazo_ativo(prazo))
+            printf("Pontos passados: %i \n", contadorPontos);
     }
 
     *distanciaTotal += calcularDistancia(coordenadas[pontoAtual], coordenadas[0]);
-    caminho[tamanho + 1] = coordenadas[0].id;
 
     free(visitado);
 }
 
-// Função para extrair coordenadas
-CoordenadaEstrela *lerCoordenadas(const char *nomeArquivo, int *tamanho)
+// Função para extrair coordenadas (.xyz.txt ou TSPLIB)
+CoordenadaEstrela *lerCoordenadas(const char *nomeArquivo, int *tamanho, char *nomeInstancia, size_t tamanhoNome)
 {
-    FILE *arquivo = fopen(nomeArquivo, "r");
-    if (arquivo == NULL)
-    {
-        perror("Erro ao abrir o arquivo");
-        exit(EXIT_FAILURE);
-    }
+    PROF_ESCOPO("leitura");
+    InstanciaTSP instancia;
+    ler_instancia(nomeArquivo, &instancia);
 
-    // Contar o número de linhas no arquivo
-    int linhas = 0;
-    float dummy_x, dummy_y, dummy_z;
-    while (fscanf(arquivo, "%f %f %f", &dummy_x, &dummy_y, &dummy_z) == 3)
-    {
-        linhas++;
-    }
-
-    rewind(arquivo); // Voltar ao início do arquivo
-
-    // Alocar dinamicamente o vetor de coordenadas
-    CoordenadaEstrela *coordenadas = (CoordenadaEstrela *)malloc(linhas * sizeof(CoordenadaEstrela));
-    if (coordenadas == NULL)
-    {
-        perror("Erro ao alocar memória");
-        exit(EXIT_FAILURE);
-    }
-
-    // Ler as coordenadas e armazenar no vetor
-    for (int i = 0; i < linhas; i++)
-    {
-        if (fscanf(arquivo, "%f %f %f", &coordenadas[i].x, &coordenadas[i].y, &coordenadas[i].z) != 3)
-        {
-            fprintf(stderr, "Erro ao ler coordenadas do arquivo\n");
-            exit(EXIT_FAILURE);
-        }
-        coordenadas[i].id = i + 1;
-    }
-
-    fclose(arquivo);
-
-    // Definir o tamanho do vetor
-    *tamanho = linhas;
+    tipoDistancia = instancia.tipo;
+    snprintf(nomeInstancia, tamanhoNome, "%s", instancia.nome);
+    *tamanho = instancia.n;
 
     // Retornar o vetor de coordenadas
-    return coordenadas;
+    return instancia.points;
 }
 
-int main()
+int main(int argc, char *argv[])
 {
     // TESTANDO OBTENCAO DE COORDENADAS
 
     const char *nomeArquivo = "C:\\Users\\Getaruck\\Documents\\TCC\\coordenadas\\star1k.xyz.txt";
-    int tamanho = 1000; // Altere de acordo com o número total de coordenadas no arquivo
-    CoordenadaEstrela *coordenadas = (CoordenadaEstrela *)malloc(tamanho * sizeof(CoordenadaEstrela));
+    const char *arquivoTour = NULL; // --tour saida.tour grava o caminho no formato TSPLIB
+    double limiteTempo = 0;
 
-    if (coordenadas == NULL)
+    for (int i = 1; i < argc; i++)
     {
-        return EXIT_FAILURE;
+        if (strcmp(argv[i], "--tour") == 0 && i + 1 < argc)
+            arquivoTour = argv[++i];
+        else if (strcmp(argv[i], "--time-limit") == 0 && i + 1 < argc)
+            limiteTempo = atof(argv[++i]);
+        else
+            nomeArquivo = argv[i];
     }
+    Prazo prazo;
+    prazo_iniciar(&prazo, limiteTempo);
 
-    coordenadas = lerCoordenadas(nomeArquivo, &tamanho);
+    int tamanho;
+    char nomeInstancia[128];
+    CoordenadaEstrela *coordenadas = lerCoordenadas(nomeArquivo, &tamanho, nomeInstancia, sizeof(nomeInstancia));
 
-    // Teste: imprimir as coordenadas
-    for (int i = 0; i < tamanho; i++)
+    if (tamanho < 1)
+    {
+        free(coordenadas);
+        return EXIT_FAILURE;
+    }
+
+    // Teste: imprimir as coordenadas (omitido com --time-limit, para não gastar o prazo)
+    for (int i = 0; i < tamanho && !prazo_ativo(&prazo); i++)
     {
         printf("ID: %d, X: %.6f, Y: %.6f, Z: %.6f\n", coordenadas[i].id, coordenadas[i].x, coordenadas[i].y, coordenadas[i].z);
     }
@@ -163,14 +162,14 @@ int main()
 
     printf("-------------------------------\n");
 
-    int caminho[tamanho + 1];
+    int *caminho = (int *)malloc(tamanho * sizeof(int));
     float distanciaGuloso;
 
-    algoritmoGulosoVizinhoMaisProximo(coordenadas, tamanho, caminho, &distanciaGuloso);
+    algoritmoGulosoVizinhoMaisProximo(coordenadas, tamanho, caminho, &distanciaGuloso, &prazo);
 
-    // Imprime o caminho
+    // Imprime o caminho (o retorno ao ponto inicial fica implícito)
     printf("Caminho: ");
-    for (int i = 0; i < tamanho + 2; i++)
+    for (int i = 0; i < tamanho; i++)
     {
         printf("%d ", caminho[i]);
     }
@@ -179,8 +178,14 @@ int main()
     // Imprime a distância total
     printf("Distância total percorrida: %.3f\n", distanciaGuloso);
 
+    if (arquivoTour != NULL)
+    {
+        gravar_tour(arquivoTour, nomeInstancia, caminho, tamanho, distanciaGuloso);
+    }
+
+    PROF_RELATORIO(stdout);
+
+    free(caminho);
     free(coordenadas);
     return EXIT_SUCCESS;
-
-    return 0;
 }
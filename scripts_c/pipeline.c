@@ -0,0 +1,1048 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE // syscall(), usado pelos contadores de -DPROFILING_PERF
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "tsplib.h"
+#include "prazo.h"
+#include "kdtree.h"
+#include "busca_local.h"
+#include "profiling.h"
+
+// Pipeline concorrente: construção gulosa -> busca local 2-opt -> GA/ACO,
+// todos os estágios compartilhando o melhor tour encontrado (quadro-negro).
+// Compilar com: gcc -O2 pipeline.c -o pipeline -lm -lpthread
+// (acrescente -DDIST_INTEIRA para custos int32, ver tsplib.h)
+
+#define TAM_POPULACAO 12    // Membros da população compartilhada do GA
+#define TAM_DEQUE 1024      // Capacidade da fila de tarefas de cada thread
+#define FORMIGAS 4          // Formigas por iteração do ACO
+#define ALPHA 1.0           // Importância do feromônio
+#define BETA 2.0            // Importância da visibilidade
+#define RHO 0.1             // Taxa de evaporação do feromônio
+#define CHUTES_ILS 50       // Perturbações double-bridge por tarefa de melhoria
+#define MAX_SEGMENTO_CHUTE 50 // Comprimento máximo de cada trecho do double-bridge
+#define PROB_SEGUNDO_VIZINHO 0.1 // Chance do guloso escolher o segundo vizinho livre
+#define LIMITE_MATRIZ 4000  // Até este tamanho as distâncias ficam numa matriz n x n
+#define ESTAGNACAO_MINIMA 0.5 // Segundos sem melhorar o incumbente antes de reiniciar
+#define FRACAO_ESTAGNACAO 0.2 // ... ou esta fração do tempo já decorrido, o que for maior
+
+typedef enum
+{
+    ESTAGIO_CONSTRUCAO,
+    ESTAGIO_BUSCA_LOCAL,
+    ESTAGIO_GA,
+    ESTAGIO_MELHORIA,
+    ESTAGIO_ACO,
+    NUM_ESTAGIOS
+} Estagio;
+
+static const char *nomes_estagios[NUM_ESTAGIOS] = {"construcao", "busca_local", "ga", "melhoria", "aco"};
+
+// Quadro-negro com o melhor tour. O comprimento e a versão são atômicos, então
+// qualquer estágio descobre se existe algo melhor sem travar nada; o mutex só é
+// usado no caminho raro de copiar ou substituir o tour em si.
+typedef struct
+{
+    _Atomic double comprimento;
+    _Atomic double ultima_melhoria; // relogio() da última publicação (ou do último reinício)
+    atomic_uint versao;
+    pthread_mutex_t lock;
+    int *tour;
+    Estagio origem;
+} QuadroNegro;
+
+typedef struct
+{
+    int *tour;
+    double comprimento;
+} Membro;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    int tam;
+    Membro membros[TAM_POPULACAO];
+} Populacao;
+
+// Estado do ACO; existe uma única tarefa de ACO por vez (ver aco_pendente), então não precisa de lock
+typedef struct
+{
+    double *feromonio;   // n * k, alinhado com a lista de candidatos
+    double *visibilidade; // (1 / d) ^ BETA de cada candidato
+    double tau_max;
+    double tau_min;
+} Colonia;
+
+typedef struct
+{
+    Estagio estagio;
+    int *tour; // Tour de entrada do estágio (pode ser NULL)
+} Tarefa;
+
+// Deque de tarefas: o dono empilha e desempilha no fim, os ladrões roubam do início
+typedef struct
+{
+    pthread_mutex_t lock;
+    Tarefa itens[TAM_DEQUE];
+    long inicio;
+    long fim;
+} Deque;
+
+struct Pipeline;
+
+typedef struct
+{
+    int id;
+    pthread_t thread;
+    Deque deque;
+    uint64_t rng;
+    struct Pipeline *pl;
+    int *incumbente;          // Cópia local do quadro-negro
+    unsigned versao_incumbente;
+    long tarefas_ga;
+    long roubos;
+} Trabalhador;
+
+typedef struct Pipeline
+{
+    Instancia *inst;
+    QuadroNegro quadro;
+    Populacao populacao;
+    Colonia colonia;
+    Trabalhador *trabalhadores;
+    int num_trabalhadores;
+    Prazo prazo;
+    atomic_long execucoes[NUM_ESTAGIOS];
+    atomic_long melhorias[NUM_ESTAGIOS];
+    _Atomic double duracao[NUM_ESTAGIOS]; // Duração da última execução de cada estágio
+    atomic_long reinicios;
+    atomic_long pendentes; // Tarefas nas filas, somando todas as threads
+    atomic_bool aco_pendente; // Já existe uma tarefa de ACO na fila ou rodando
+} Pipeline;
+
+// Gerador xorshift64*, um por thread (rand() não é seguro entre threads)
+static uint64_t rng_proximo(uint64_t *s)
+{
+    *s ^= *s >> 12;
+    *s ^= *s << 25;
+    *s ^= *s >> 27;
+    return *s * 2685821657736338717ULL;
+}
+
+static int rng_int(uint64_t *s, int limite)
+{
+    return (int)(rng_proximo(s) % (uint64_t)limite);
+}
+
+static double rng_double(uint64_t *s)
+{
+    return (rng_proximo(s) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// LISTAS DE CANDIDATOS (a árvore k-d fica em inst->arvore até o fim, para as construções)
+
+typedef struct
+{
+    Instancia *inst;
+    int inicio;
+    int fim;
+} FaixaVizinhos;
+
+static void *calcular_faixa_vizinhos(void *arg)
+{
+    FaixaVizinhos *faixa = arg;
+    for (int i = faixa->inicio; i < faixa->fim; i++)
+    {
+        preencher_vizinhos(faixa->inst, i);
+    }
+    return NULL;
+}
+
+static void calcular_vizinhos(Instancia *inst, int num_threads)
+{
+    PROF_ESCOPO("listas_candidatos");
+    inst->k = inst->n - 1 < K_VIZINHOS ? inst->n - 1 : K_VIZINHOS;
+    inst->vizinhos = malloc((size_t)inst->n * inst->k * sizeof(int));
+    inst->custos = malloc((size_t)inst->n * inst->k * sizeof(custo_t));
+
+    pthread_t threads[num_threads];
+    FaixaVizinhos faixas[num_threads];
+    for (int t = 0; t < num_threads; t++)
+    {
+        faixas[t].inst = inst;
+        faixas[t].inicio = (int)((long)inst->n * t / num_threads);
+        faixas[t].fim = (int)((long)inst->n * (t + 1) / num_threads);
+        pthread_create(&threads[t], NULL, calcular_faixa_vizinhos, &faixas[t]);
+    }
+    for (int t = 0; t < num_threads; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+}
+
+// Posição do ponto 'v' na lista de candidatos de 'u', ou -1
+static int indice_candidato(const Instancia *inst, int u, int v)
+{
+    for (int j = 0; j < inst->k; j++)
+    {
+        if (inst->vizinhos[u * inst->k + j] == v)
+            return j;
+    }
+    return -1;
+}
+
+// QUADRO-NEGRO
+
+static void iniciar_quadro(QuadroNegro *quadro, int n)
+{
+    atomic_init(&quadro->comprimento, INFINITY);
+    atomic_init(&quadro->ultima_melhoria, relogio());
+    atomic_init(&quadro->versao, 0);
+    pthread_mutex_init(&quadro->lock, NULL);
+    quadro->tour = malloc(n * sizeof(int));
+    quadro->origem = ESTAGIO_CONSTRUCAO;
+}
+
+// Publica o tour se ele for melhor que o atual. A comparação inicial é só uma
+// leitura atômica, então tours piores (o caso comum) nunca tocam o mutex.
+static bool publicar(Pipeline *pl, const int *tour, double comprimento, Estagio origem)
+{
+    QuadroNegro *quadro = &pl->quadro;
+    if (comprimento >= atomic_load_explicit(&quadro->comprimento, memory_order_relaxed))
+        return false;
+
+    bool publicado = false;
+    pthread_mutex_lock(&quadro->lock);
+    if (comprimento < atomic_load_explicit(&quadro->comprimento, memory_order_relaxed))
+    {
+        memcpy(quadro->tour, tour, pl->inst->n * sizeof(int));
+        quadro->origem = origem;
+        atomic_store_explicit(&quadro->comprimento, comprimento, memory_order_release);
+        atomic_store_explicit(&quadro->ultima_melhoria, relogio(), memory_order_relaxed);
+        atomic_fetch_add_explicit(&quadro->versao, 1, memory_order_release);
+        publicado = true;
+    }
+    pthread_mutex_unlock(&quadro->lock);
+
+    if (publicado)
+        atomic_fetch_add(&pl->melhorias[origem], 1);
+    return publicado;
+}
+
+// Atualiza a cópia local do incumbente; só trava se a versão mudou
+static bool buscar_incumbente(Trabalhador *w)
+{
+    QuadroNegro *quadro = &w->pl->quadro;
+    unsigned versao = atomic_load_explicit(&quadro->versao, memory_order_acquire);
+    if (versao == 0)
+        return false;
+    if (versao == w->versao_incumbente)
+        return true;
+
+    pthread_mutex_lock(&quadro->lock);
+    memcpy(w->incumbente, quadro->tour, w->pl->inst->n * sizeof(int));
+    w->versao_incumbente = atomic_load_explicit(&quadro->versao, memory_order_relaxed);
+    pthread_mutex_unlock(&quadro->lock);
+    return true;
+}
+
+// POPULAÇÃO
+
+static void populacao_inserir(Pipeline *pl, const int *tour, double comprimento)
+{
+    Populacao *pop = &pl->populacao;
+    int n = pl->inst->n;
+
+    pthread_mutex_lock(&pop->lock);
+    int pior = -1;
+    bool repetido = false;
+    for (int i = 0; i < pop->tam; i++)
+    {
+        if (fabs(pop->membros[i].comprimento - comprimento) < 1e-7)
+            repetido = true;
+        if (pior < 0 || pop->membros[i].comprimento > pop->membros[pior].comprimento)
+            pior = i;
+    }
+    if (!repetido)
+    {
+        if (pop->tam < TAM_POPULACAO)
+        {
+            pop->membros[pop->tam].tour = malloc(n * sizeof(int));
+            memcpy(pop->membros[pop->tam].tour, tour, n * sizeof(int));
+            pop->membros[pop->tam].comprimento = comprimento;
+            pop->tam++;
+        }
+        else if (comprimento < pop->membros[pior].comprimento)
+        {
+            memcpy(pop->membros[pior].tour, tour, n * sizeof(int));
+            pop->membros[pior].comprimento = comprimento;
+        }
+    }
+    pthread_mutex_unlock(&pop->lock);
+}
+
+// Copia um membro escolhido por torneio binário; retorna false se a população está vazia
+static bool populacao_sortear(Pipeline *pl, int *destino, double *comprimento, uint64_t *rng)
+{
+    Populacao *pop = &pl->populacao;
+    bool ok = false;
+
+    pthread_mutex_lock(&pop->lock);
+    if (pop->tam > 0)
+    {
+        Membro *a = &pop->membros[rng_int(rng, pop->tam)];
+        Membro *b = &pop->membros[rng_int(rng, pop->tam)];
+        Membro *escolhido = a->comprimento < b->comprimento ? a : b;
+        memcpy(destino, escolhido->tour, pl->inst->n * sizeof(int));
+        *comprimento = escolhido->comprimento;
+        ok = true;
+    }
+    pthread_mutex_unlock(&pop->lock);
+    return ok;
+}
+
+// Descarta todos os membros menos o melhor, abrindo espaço para tours novos
+static void populacao_reiniciar(Pipeline *pl)
+{
+    Populacao *pop = &pl->populacao;
+    pthread_mutex_lock(&pop->lock);
+    int melhor = 0;
+    for (int i = 1; i < pop->tam; i++)
+    {
+        if (pop->membros[i].comprimento < pop->membros[melhor].comprimento)
+            melhor = i;
+    }
+    for (int i = 0; i < pop->tam; i++)
+    {
+        if (i != melhor)
+            free(pop->membros[i].tour);
+    }
+    if (pop->tam > 0)
+    {
+        pop->membros[0] = pop->membros[melhor];
+        pop->tam = 1;
+    }
+    pthread_mutex_unlock(&pop->lock);
+}
+
+static int populacao_tamanho(Pipeline *pl)
+{
+    pthread_mutex_lock(&pl->populacao.lock);
+    int tam = pl->populacao.tam;
+    pthread_mutex_unlock(&pl->populacao.lock);
+    return tam;
+}
+
+// CONSTRUÇÃO E BUSCA LOCAL
+
+// Vizinho mais próximo usando as listas de candidatos; quando todos os
+// candidatos já foram visitados, pega o livre mais próximo na árvore k-d
+static int *construir_vizinho_mais_proximo(const Instancia *inst, int inicio, uint64_t *rng)
+{
+    PROF_ESCOPO("vizinho_mais_proximo");
+    int n = inst->n;
+    int *tour = malloc(n * sizeof(int));
+    bool *visitado = calloc(n, sizeof(bool));
+    int *livres = malloc(n * sizeof(int));
+    iniciar_livres(inst->arvore, livres);
+
+    int atual = inicio;
+    for (int passo = 0; passo < n; passo++)
+    {
+        tour[passo] = atual;
+        visitado[atual] = true;
+        retirar_livre(inst->arvore, livres, atual);
+        if (passo == n - 1)
+            break;
+
+        int proximo = -1;
+        bool pular = rng_double(rng) < PROB_SEGUNDO_VIZINHO;
+        for (int j = 0; j < inst->k; j++)
+        {
+            int c = inst->vizinhos[atual * inst->k + j];
+            if (!visitado[c])
+            {
+                proximo = c;
+                if (!pular)
+                    break;
+                pular = false;
+            }
+        }
+        if (proximo < 0)
+            proximo = buscar_livre(inst->arvore, livres, &inst->points[atual]);
+        atual = proximo;
+    }
+
+    free(visitado);
+    free(livres);
+    return tour;
+}
+
+// Double-bridge com trechos curtos: A B C D -> A C B D. Grava em 'tocados'
+// as 6 extremidades das arestas novas e retorna quantas foram gravadas.
+static int double_bridge(int *tour, int n, uint64_t *rng, int *tocados)
+{
+    if (n < 8)
+        return 0;
+    int max_segmento = (n - 2) / 3 < MAX_SEGMENTO_CHUTE ? (n - 2) / 3 : MAX_SEGMENTO_CHUTE;
+    int p = rng_int(rng, n);
+    int tam_b = 1 + rng_int(rng, max_segmento);
+    int tam_c = 1 + rng_int(rng, max_segmento);
+
+    // B = tour[p+1 .. p+tam_b], C = logo em seguida; troca os dois de lugar
+    int temp[2 * MAX_SEGMENTO_CHUTE];
+    for (int i = 0; i < tam_b + tam_c; i++)
+    {
+        temp[i] = tour[(p + 1 + i) % n];
+    }
+    for (int i = 0; i < tam_c; i++)
+    {
+        tour[(p + 1 + i) % n] = temp[tam_b + i];
+    }
+    for (int i = 0; i < tam_b; i++)
+    {
+        tour[(p + 1 + tam_c + i) % n] = temp[i];
+    }
+
+    int fim = (p + tam_b + tam_c) % n;
+    tocados[0] = tour[p];
+    tocados[1] = tour[(p + 1) % n];
+    tocados[2] = tour[(p + tam_c) % n];
+    tocados[3] = tour[(p + tam_c + 1) % n];
+    tocados[4] = tour[fim];
+    tocados[5] = tour[(fim + 1) % n];
+    return 6;
+}
+
+// Cruzamento OX: copia um trecho do pai 1 e completa na ordem do pai 2
+static void cruzamento_ox(const int *pai1, const int *pai2, int *filho, int n, uint64_t *rng, bool *usado)
+{
+    PROF_ESCOPO("cruzamento_ox");
+    int inicio = rng_int(rng, n);
+    int fim = rng_int(rng, n);
+    if (inicio > fim)
+    {
+        int temp = inicio;
+        inicio = fim;
+        fim = temp;
+    }
+    memset(usado, 0, n * sizeof(bool));
+    for (int i = inicio; i <= fim; i++)
+    {
+        filho[i] = pai1[i];
+        usado[pai1[i]] = true;
+    }
+    int destino = (fim + 1) % n;
+    for (int i = 0; i < n; i++)
+    {
+        int gene = pai2[(fim + 1 + i) % n];
+        if (!usado[gene])
+        {
+            filho[destino] = gene;
+            destino = (destino + 1) % n;
+        }
+    }
+}
+
+// ESTÁGIOS
+
+static void submeter(Trabalhador *w, Estagio estagio, int *tour);
+
+// Quando o incumbente para de melhorar e o prazo restante ainda comporta
+// construir e otimizar tours novos, reinicia a população a partir do melhor.
+// Só uma thread ganha o compare-exchange e faz o reinício.
+static bool reiniciar_se_estagnado(Pipeline *pl)
+{
+    double t = relogio();
+    double ultima = atomic_load_explicit(&pl->quadro.ultima_melhoria, memory_order_relaxed);
+    double limite = fmax(ESTAGNACAO_MINIMA, FRACAO_ESTAGNACAO * (t - pl->prazo.inicio));
+    if (t - ultima < limite)
+        return false;
+
+    double custo = 2.0 * (atomic_load(&pl->duracao[ESTAGIO_CONSTRUCAO]) + atomic_load(&pl->duracao[ESTAGIO_BUSCA_LOCAL]));
+    if (prazo_restante(&pl->prazo) < custo)
+        return false;
+    if (!atomic_compare_exchange_strong(&pl->quadro.ultima_melhoria, &ultima, t))
+        return false;
+
+    populacao_reiniciar(pl);
+    atomic_fetch_add(&pl->reinicios, 1);
+    return true;
+}
+
+static void estagio_construcao(Trabalhador *w, Tarefa *t)
+{
+    (void)t;
+    const Instancia *inst = w->pl->inst;
+    int *tour = construir_vizinho_mais_proximo(inst, rng_int(&w->rng, inst->n), &w->rng);
+    publicar(w->pl, tour, comprimento_tour(inst, tour), ESTAGIO_CONSTRUCAO);
+    submeter(w, ESTAGIO_BUSCA_LOCAL, tour);
+}
+
+static void estagio_busca_local(Trabalhador *w, Tarefa *t)
+{
+    Pipeline *pl = w->pl;
+    busca_local(pl->inst, t->tour, NULL, 0, &pl->prazo);
+    double comprimento = comprimento_tour(pl->inst, t->tour);
+    publicar(pl, t->tour, comprimento, ESTAGIO_BUSCA_LOCAL);
+    populacao_inserir(pl, t->tour, comprimento);
+
+    // Enquanto a população ainda está pela metade, continua construindo
+    if (populacao_tamanho(pl) < TAM_POPULACAO / 2)
+        submeter(w, ESTAGIO_CONSTRUCAO, NULL);
+    else
+        submeter(w, ESTAGIO_GA, NULL);
+}
+
+static void estagio_ga(Trabalhador *w, Tarefa *t)
+{
+    (void)t;
+    Pipeline *pl = w->pl;
+    int n = pl->inst->n;
+    int *pai1 = malloc(n * sizeof(int));
+    int *pai2 = malloc(n * sizeof(int));
+    int *filho = malloc(n * sizeof(int));
+    bool *usado = malloc(n * sizeof(bool));
+    double c1, c2;
+
+    if (populacao_sortear(pl, pai1, &c1, &w->rng) && populacao_sortear(pl, pai2, &c2, &w->rng))
+    {
+        cruzamento_ox(pai1, pai2, filho, n, &w->rng, usado);
+
+        // Só os pontos de arestas que não vieram de nenhum dos pais precisam de busca local
+        int *suc1 = malloc(n * sizeof(int));
+        int *suc2 = malloc(n * sizeof(int));
+        int *ativos = malloc(2 * n * sizeof(int));
+        int num_ativos = 0;
+        for (int i = 0; i < n; i++)
+        {
+            suc1[pai1[i]] = pai1[(i + 1) % n];
+            suc2[pai2[i]] = pai2[(i + 1) % n];
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            int u = filho[i], v = filho[(i + 1) % n];
+            bool herdada = suc1[u] == v || suc1[v] == u || suc2[u] == v || suc2[v] == u;
+            if (!herdada)
+            {
+                ativos[num_ativos++] = u;
+                ativos[num_ativos++] = v;
+            }
+        }
+
+        busca_local(pl->inst, filho, ativos, num_ativos, &pl->prazo);
+        double comprimento = comprimento_tour(pl->inst, filho);
+        publicar(pl, filho, comprimento, ESTAGIO_GA);
+        populacao_inserir(pl, filho, comprimento);
+        free(suc1);
+        free(suc2);
+        free(ativos);
+    }
+
+    free(pai1);
+    free(pai2);
+    free(filho);
+    free(usado);
+
+    if (reiniciar_se_estagnado(pl))
+    {
+        submeter(w, ESTAGIO_CONSTRUCAO, NULL);
+        return;
+    }
+
+    // Com menos tarefas nas filas do que threads, gera dois filhos em vez de
+    // um; o excedente fica na fila para as threads ociosas roubarem
+    int filhos = atomic_load(&pl->pendentes) < pl->num_trabalhadores ? 2 : 1;
+    for (int f = 0; f < filhos; f++)
+    {
+        // De tempos em tempos um membro da população passa por melhoria (ILS)
+        if (++w->tarefas_ga % 3 == 0)
+            submeter(w, ESTAGIO_MELHORIA, NULL);
+        else
+            submeter(w, ESTAGIO_GA, NULL);
+    }
+
+    // Uma iteração de ACO a cada poucas tarefas do GA, nunca duas ao mesmo tempo
+    bool livre = false;
+    if (w->tarefas_ga % 4 == 1 && atomic_compare_exchange_strong(&pl->aco_pendente, &livre, true))
+        submeter(w, ESTAGIO_ACO, NULL);
+}
+
+// Busca local iterada a partir do incumbente (ou de um membro da população)
+static void estagio_melhoria(Trabalhador *w, Tarefa *t)
+{
+    (void)t;
+    Pipeline *pl = w->pl;
+    int n = pl->inst->n;
+    int *atual = malloc(n * sizeof(int));
+    int *candidato = malloc(n * sizeof(int));
+    double comprimento;
+
+    bool ok;
+    if (rng_double(&w->rng) < 0.5 && buscar_incumbente(w))
+    {
+        memcpy(atual, w->incumbente, n * sizeof(int));
+        comprimento = comprimento_tour(pl->inst, atual);
+        ok = true;
+    }
+    else
+    {
+        ok = populacao_sortear(pl, atual, &comprimento, &w->rng);
+    }
+
+    if (ok && n >= 8)
+    {
+        int tocados[6];
+        for (int chute = 0; chute < CHUTES_ILS && !prazo_expirou(&pl->prazo); chute++)
+        {
+            memcpy(candidato, atual, n * sizeof(int));
+            int num_tocados = double_bridge(candidato, n, &w->rng, tocados);
+            busca_local(pl->inst, candidato, tocados, num_tocados, &pl->prazo);
+            double novo = comprimento_tour(pl->inst, candidato);
+            if (novo < comprimento)
+            {
+                int *temp = atual;
+                atual = candidato;
+                candidato = temp;
+                comprimento = novo;
+            }
+        }
+        publicar(pl, atual, comprimento, ESTAGIO_MELHORIA);
+        populacao_inserir(pl, atual, comprimento);
+    }
+
+    free(atual);
+    free(candidato);
+    // Sem sucessor: a thread segue com o que houver na própria fila ou rouba
+}
+
+static void iniciar_colonia(Colonia *colonia, const Instancia *inst)
+{
+    size_t total = (size_t)inst->n * inst->k;
+    colonia->feromonio = malloc(total * sizeof(double));
+    colonia->visibilidade = malloc(total * sizeof(double));
+    colonia->tau_max = 1.0;
+    colonia->tau_min = 1.0 / (2.0 * inst->n);
+    for (size_t i = 0; i < total; i++)
+    {
+        colonia->feromonio[i] = colonia->tau_max;
+        colonia->visibilidade[i] = pow(1.0 / ((double)inst->custos[i] + 1e-10), BETA);
+    }
+}
+
+// Uma formiga: escolhe entre os candidatos não visitados pela regra
+// proporcional e, se não houver nenhum, vai para o ponto livre mais próximo
+static void construir_formiga(const Instancia *inst, const Colonia *colonia, int *tour, bool *visitado,
+                              int *livres, uint64_t *rng)
+{
+    PROF_ESCOPO("construcao_formiga");
+    int n = inst->n;
+    int k = inst->k;
+    double prob[K_VIZINHOS];
+    memset(visitado, 0, n * sizeof(bool));
+    iniciar_livres(inst->arvore, livres);
+
+    int atual = rng_int(rng, n);
+    for (int passo = 0; passo < n; passo++)
+    {
+        tour[passo] = atual;
+        visitado[atual] = true;
+        retirar_livre(inst->arvore, livres, atual);
+        if (passo == n - 1)
+            break;
+
+        double total = 0.0;
+        for (int j = 0; j < k; j++)
+        {
+            int c = inst->vizinhos[atual * k + j];
+            prob[j] = visitado[c] ? 0.0 : pow(colonia->feromonio[atual * k + j], ALPHA) * colonia->visibilidade[atual * k + j];
+            total += prob[j];
+        }
+
+        int proximo = -1;
+        if (total > 0.0)
+        {
+            double r = rng_double(rng) * total;
+            double acumulado = 0.0;
+            for (int j = 0; j < k; j++)
+            {
+                if (prob[j] > 0.0)
+                {
+                    proximo = inst->vizinhos[atual * k + j];
+                    acumulado += prob[j];
+                    if (acumulado >= r)
+                        break;
+                }
+            }
+        }
+        else
+        {
+            proximo = buscar_livre(inst->arvore, livres, &inst->points[atual]);
+        }
+        atual = proximo;
+    }
+}
+
+// Reforça as arestas do tour que estão nas listas de candidatos
+static void depositar(const Instancia *inst, Colonia *colonia, const int *tour, double quantidade)
+{
+    PROF_ESCOPO("feromonio");
+    int n = inst->n;
+    for (int i = 0; i < n; i++)
+    {
+        int u = tour[i], v = tour[(i + 1) % n];
+        int j = indice_candidato(inst, u, v);
+        if (j >= 0)
+            colonia->feromonio[u * inst->k + j] += quantidade;
+        j = indice_candidato(inst, v, u);
+        if (j >= 0)
+            colonia->feromonio[v * inst->k + j] += quantidade;
+    }
+}
+
+// Uma iteração do MAX-MIN Ant System, semeado pelo incumbente do quadro-negro
+static void estagio_aco(Trabalhador *w, Tarefa *t)
+{
+    (void)t;
+    Pipeline *pl = w->pl;
+    const Instancia *inst = pl->inst;
+    Colonia *colonia = &pl->colonia;
+    int n = inst->n;
+
+    int *formiga = malloc(n * sizeof(int));
+    int *melhor = malloc(n * sizeof(int));
+    bool *visitado = malloc(n * sizeof(bool));
+    int *livres = malloc(n * sizeof(int));
+    double melhor_comprimento = INFINITY;
+
+    for (int f = 0; f < FORMIGAS && !prazo_expirou(&pl->prazo); f++)
+    {
+        construir_formiga(inst, colonia, formiga, visitado, livres, &w->rng);
+        double comprimento = comprimento_tour(inst, formiga);
+        if (comprimento < melhor_comprimento)
+        {
+            melhor_comprimento = comprimento;
+            int *temp = melhor;
+            melhor = formiga;
+            formiga = temp;
+        }
+    }
+
+    if (melhor_comprimento < INFINITY)
+    {
+        busca_local(inst, melhor, NULL, 0, &pl->prazo);
+        melhor_comprimento = comprimento_tour(inst, melhor);
+        publicar(pl, melhor, melhor_comprimento, ESTAGIO_ACO);
+        populacao_inserir(pl, melhor, melhor_comprimento);
+
+        // Evaporação e depósito na melhor formiga e no incumbente global
+        size_t total = (size_t)n * inst->k;
+        for (size_t i = 0; i < total; i++)
+            colonia->feromonio[i] *= 1.0 - RHO;
+        depositar(inst, colonia, melhor, RHO * colonia->tau_max * 0.5);
+        if (buscar_incumbente(w))
+        {
+            double incumbente = atomic_load_explicit(&pl->quadro.comprimento, memory_order_relaxed);
+            colonia->tau_max = 1.0 / (RHO * incumbente);
+            colonia->tau_min = colonia->tau_max / (2.0 * n);
+            depositar(inst, colonia, w->incumbente, RHO * colonia->tau_max);
+        }
+        for (size_t i = 0; i < total; i++)
+        {
+            if (colonia->feromonio[i] > colonia->tau_max)
+                colonia->feromonio[i] = colonia->tau_max;
+            else if (colonia->feromonio[i] < colonia->tau_min)
+                colonia->feromonio[i] = colonia->tau_min;
+        }
+    }
+
+    free(formiga);
+    free(melhor);
+    free(visitado);
+    free(livres);
+    atomic_store(&pl->aco_pendente, false);
+}
+
+static void (*const executores[NUM_ESTAGIOS])(Trabalhador *, Tarefa *) = {
+    estagio_construcao, estagio_busca_local, estagio_ga, estagio_melhoria, estagio_aco};
+
+// POOL COM ROUBO DE TAREFAS
+
+static bool deque_empilhar(Deque *d, Tarefa t)
+{
+    pthread_mutex_lock(&d->lock);
+    bool ok = d->fim - d->inicio < TAM_DEQUE;
+    if (ok)
+    {
+        d->itens[d->fim % TAM_DEQUE] = t;
+        d->fim++;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+// O dono retira do fim (LIFO, o tour recém-produzido ainda está no cache)
+static bool deque_desempilhar(Deque *d, Tarefa *t)
+{
+    pthread_mutex_lock(&d->lock);
+    bool ok = d->fim > d->inicio;
+    if (ok)
+    {
+        d->fim--;
+        *t = d->itens[d->fim % TAM_DEQUE];
+    }
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+// Ladrões retiram do início (as tarefas mais antigas)
+static bool deque_roubar(Deque *d, Tarefa *t)
+{
+    if (pthread_mutex_trylock(&d->lock) != 0)
+        return false;
+    bool ok = d->fim > d->inicio;
+    if (ok)
+    {
+        *t = d->itens[d->inicio % TAM_DEQUE];
+        d->inicio++;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+static void executar(Trabalhador *w, Tarefa *t)
+{
+    atomic_fetch_add(&w->pl->execucoes[t->estagio], 1);
+    double inicio = relogio();
+    {
+        PROF_ESCOPO_DINAMICO(nomes_estagios[t->estagio]);
+        executores[t->estagio](w, t);
+    }
+    atomic_store(&w->pl->duracao[t->estagio], relogio() - inicio);
+    if (t->estagio == ESTAGIO_BUSCA_LOCAL)
+        free(t->tour);
+}
+
+static void submeter(Trabalhador *w, Estagio estagio, int *tour)
+{
+    if (prazo_expirou(&w->pl->prazo))
+    {
+        free(tour);
+        return;
+    }
+    Tarefa t = {estagio, tour};
+    if (deque_empilhar(&w->deque, t))
+        atomic_fetch_add(&w->pl->pendentes, 1);
+    else
+        executar(w, &t);
+}
+
+static bool roubar(Trabalhador *w, Tarefa *t)
+{
+    Pipeline *pl = w->pl;
+    int inicio = rng_int(&w->rng, pl->num_trabalhadores);
+    for (int i = 0; i < pl->num_trabalhadores; i++)
+    {
+        Trabalhador *vitima = &pl->trabalhadores[(inicio + i) % pl->num_trabalhadores];
+        if (vitima != w && deque_roubar(&vitima->deque, t))
+        {
+            w->roubos++;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void *laco_trabalhador(void *arg)
+{
+    Trabalhador *w = arg;
+    Pipeline *pl = w->pl;
+    struct timespec espera = {0, 200000};
+    while (!prazo_expirou(&pl->prazo))
+    {
+        Tarefa t;
+        if (deque_desempilhar(&w->deque, &t) || roubar(w, &t))
+        {
+            atomic_fetch_sub(&pl->pendentes, 1);
+            executar(w, &t);
+        }
+        else if (atomic_load(&pl->pendentes) == 0 && populacao_tamanho(pl) > 0)
+            submeter(w, ESTAGIO_GA, NULL); // Todas as filas vazias: recomeça pelo GA
+        else
+            nanosleep(&espera, NULL);
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *nome_arquivo = "../coordenadas/star1k.xyz.txt";
+    const char *arquivo_tour = NULL;
+    double limite_tempo = 10.0;
+    int num_threads = 4;
+    uint64_t semente = (uint64_t)time(NULL);
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--time-limit") == 0 && i + 1 < argc)
+            limite_tempo = atof(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            num_threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--tour") == 0 && i + 1 < argc)
+            arquivo_tour = argv[++i];
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            semente = strtoull(argv[++i], NULL, 10);
+        else
+            nome_arquivo = argv[i];
+    }
+    if (num_threads < 1)
+        num_threads = 1;
+    if (limite_tempo <= 0)
+    {
+        fprintf(stderr, "O pipeline precisa de um --time-limit positivo\n");
+        return EXIT_FAILURE;
+    }
+
+    double inicio = relogio();
+    InstanciaTSP lida;
+    ler_instancia(nome_arquivo, &lida);
+    Instancia inst = {.n = lida.n, .tipo = lida.tipo, .points = lida.points};
+    if (inst.n < 3)
+    {
+        fprintf(stderr, "Instancia precisa de pelo menos 3 pontos\n");
+        return EXIT_FAILURE;
+    }
+    if (inst.n <= LIMITE_MATRIZ)
+        inst.matriz = calcular_matriz(&lida, inst.n);
+    ArvoreKd arvore;
+    construir_arvore(&arvore, inst.points, inst.n);
+    inst.arvore = &arvore;
+    calcular_vizinhos(&inst, num_threads);
+    printf("Pontos: %d, listas de candidatos em %.3f s\n", inst.n, relogio() - inicio);
+
+    Pipeline pl;
+    memset(&pl, 0, sizeof(pl));
+    pl.inst = &inst;
+    pl.num_trabalhadores = num_threads;
+    iniciar_quadro(&pl.quadro, inst.n);
+    pthread_mutex_init(&pl.populacao.lock, NULL);
+    iniciar_colonia(&pl.colonia, &inst);
+    for (int e = 0; e < NUM_ESTAGIOS; e++)
+    {
+        atomic_init(&pl.execucoes[e], 0);
+        atomic_init(&pl.melhorias[e], 0);
+        atomic_init(&pl.duracao[e], 0.0);
+    }
+    atomic_init(&pl.reinicios, 0);
+    atomic_init(&pl.pendentes, 0);
+    atomic_init(&pl.aco_pendente, false);
+
+    pl.trabalhadores = calloc(num_threads, sizeof(Trabalhador));
+    for (int t = 0; t < num_threads; t++)
+    {
+        Trabalhador *w = &pl.trabalhadores[t];
+        w->id = t;
+        w->pl = &pl;
+        w->rng = semente * 0x9E3779B97F4A7C15ULL + t + 1;
+        w->incumbente = malloc(inst.n * sizeof(int));
+        pthread_mutex_init(&w->deque.lock, NULL);
+    }
+
+    // Uma construção por thread, todas na fila da thread 0: as outras começam
+    // roubando. O ACO só entra depois, pelo GA, quando já há incumbente.
+    pl.prazo.inicio = inicio;
+    pl.prazo.fim = inicio + limite_tempo;
+    for (int t = 0; t < num_threads; t++)
+    {
+        Tarefa construcao = {ESTAGIO_CONSTRUCAO, NULL};
+        deque_empilhar(&pl.trabalhadores[0].deque, construcao);
+    }
+    atomic_store(&pl.pendentes, num_threads);
+
+    for (int t = 0; t < num_threads; t++)
+    {
+        pthread_create(&pl.trabalhadores[t].thread, NULL, laco_trabalhador, &pl.trabalhadores[t]);
+    }
+    for (int t = 0; t < num_threads; t++)
+    {
+        pthread_join(pl.trabalhadores[t].thread, NULL);
+    }
+
+    // Descartar tarefas que sobraram nas filas
+    long roubos = 0;
+    for (int t = 0; t < num_threads; t++)
+    {
+        Trabalhador *w = &pl.trabalhadores[t];
+        Tarefa resto;
+        while (deque_desempilhar(&w->deque, &resto))
+            free(resto.tour);
+        roubos += w->roubos;
+    }
+
+    // Se o prazo acabou antes de qualquer estágio publicar, o quadro-negro
+    // ainda está vazio: constrói um tour guloso fora do prazo para ter resposta
+    if (atomic_load(&pl.quadro.versao) == 0)
+    {
+        printf("Prazo esgotado antes do primeiro tour; construindo um pelo vizinho mais proximo\n");
+        int *tour = construir_vizinho_mais_proximo(&inst, 0, &pl.trabalhadores[0].rng);
+        publicar(&pl, tour, comprimento_tour(&inst, tour), ESTAGIO_CONSTRUCAO);
+        free(tour);
+    }
+
+    printf("Tempo total: %.3f s, roubos de tarefa: %ld, reinicios: %ld\n", relogio() - inicio, roubos,
+           atomic_load(&pl.reinicios));
+    for (int e = 0; e < NUM_ESTAGIOS; e++)
+    {
+        printf("  %-12s execucoes: %6ld  melhorias do incumbente: %ld\n", nomes_estagios[e],
+               atomic_load(&pl.execucoes[e]), atomic_load(&pl.melhorias[e]));
+    }
+
+    // Imprimir o melhor caminho encontrado
+    printf("Melhor caminho encontrado (estagio: %s):\n", nomes_estagios[pl.quadro.origem]);
+    for (int i = 0; i < inst.n; i++)
+    {
+        printf("%d ", inst.points[pl.quadro.tour[i]].id);
+    }
+    printf("\n");
+    printf("Comprimento do melhor caminho: %.6f\n", atomic_load(&pl.quadro.comprimento));
+
+    if (arquivo_tour != NULL)
+    {
+        int *ids = malloc(inst.n * sizeof(int));
+        for (int i = 0; i < inst.n; i++)
+            ids[i] = inst.points[pl.quadro.tour[i]].id;
+        gravar_tour(arquivo_tour, lida.nome, ids, inst.n, atomic_load(&pl.quadro.comprimento));
+        free(ids);
+    }
+
+    PROF_RELATORIO(stdout);
+
+    // Liberar a memória alocada
+    for (int t = 0; t < num_threads; t++)
+    {
+        free(pl.trabalhadores[t].incumbente);
+    }
+    free(pl.trabalhadores);
+    for (int i = 0; i < pl.populacao.tam; i++)
+    {
+        free(pl.populacao.membros[i].tour);
+    }
+    free(pl.colonia.feromonio);
+    free(pl.colonia.visibilidade);
+    free(pl.quadro.tour);
+    liberar_arvore(&arvore);
+    liberar_instancia(&lida);
+    free(inst.matriz);
+    free(inst.vizinhos);
+    free(inst.custos);
+    return 0;
+}
@@ -0,0 +1,52 @@
+#ifndef PRAZO_H
+#define PRAZO_H
+
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+
+// Prazo de execução (--time-limit) medido em relógio monotônico. Sem limite,
+// 'fim' fica em INFINITY e os solvers seguem seus critérios de parada antigos.
+
+typedef struct
+{
+    double inicio;
+    double fim;
+} Prazo;
+
+// Relógio monotônico em segundos
+static inline double relogio(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// segundos <= 0 significa sem limite de tempo
+static inline void prazo_iniciar(Prazo *prazo, double segundos)
+{
+    prazo->inicio = relogio();
+    prazo->fim = segundos > 0 ? prazo->inicio + segundos : INFINITY;
+}
+
+static inline bool prazo_ativo(const Prazo *prazo)
+{
+    return prazo->fim < INFINITY;
+}
+
+static inline bool prazo_expirou(const Prazo *prazo)
+{
+    return prazo_ativo(prazo) && relogio() >= prazo->fim;
+}
+
+static inline double prazo_decorrido(const Prazo *prazo)
+{
+    return relogio() - prazo->inicio;
+}
+
+static inline double prazo_restante(const Prazo *prazo)
+{
+    return prazo->fim - relogio();
+}
+
+#endif
@@ -0,0 +1,307 @@
+#ifndef PROFILING_H
+#define PROFILING_H
+
+// Instrumentação por fase dos solvers, ligada na compilação:
+//
+//   -DPROFILING        tempo e número de chamadas de cada fase, por thread
+//   -DPROFILING_PERF   (Linux) também ciclos, instruções, cache misses e
+//                      branch misses via perf_event_open
+//
+// Uso: PROF_ESCOPO("crossover"); no início de um bloco mede até o fim do
+// bloco (gcc/clang, __attribute__((cleanup))). Escopos aninhados são
+// inclusivos. PROF_RELATORIO(stdout) imprime o resumo e libera os acumuladores
+// e contadores; chame uma vez, no fim, depois do join das threads.
+// Sem -DPROFILING as macros não geram código.
+//
+// Cada escopo custa duas leituras de relógio; com PROFILING_PERF, também duas
+// chamadas read(), então em funções muito curtas (calculate_fitness com
+// n = 100) o próprio instrumento domina o tempo medido.
+
+#ifdef PROFILING
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "prazo.h"
+
+#if defined(PROFILING_PERF) && defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#define PROF_COM_PERF 1
+#endif
+
+#define PROF_MAX_FASES 32
+#define PROF_MAX_THREADS 64
+#define PROF_NUM_CONTADORES 4
+
+static const char *const prof_nomes_contadores[PROF_NUM_CONTADORES] = {"ciclos", "instrucoes", "cache_miss", "branch_miss"};
+
+// Acumuladores de uma thread; só a própria thread escreve neles
+typedef struct
+{
+    int indice;
+    double tempo[PROF_MAX_FASES];
+    long chamadas[PROF_MAX_FASES];
+    uint64_t contadores[PROF_MAX_FASES][PROF_NUM_CONTADORES];
+    int fd_perf; // Líder do grupo de contadores, -1 se indisponível
+    int fds[PROF_NUM_CONTADORES]; // Todos os contadores do grupo (o líder é fds[0])
+} ProfThread;
+
+typedef struct
+{
+    int fase;
+    double t0;
+    uint64_t c0[PROF_NUM_CONTADORES];
+} ProfEscopo;
+
+static pthread_mutex_t prof_lock = PTHREAD_MUTEX_INITIALIZER;
+static const char *prof_nomes[PROF_MAX_FASES];
+static int prof_num_fases = 0;
+static ProfThread *prof_threads[PROF_MAX_THREADS];
+static int prof_num_threads = 0;
+static _Thread_local ProfThread *prof_local = NULL;
+
+// Índice da fase com esse nome (cria se não existir)
+static inline int prof_registrar(const char *nome)
+{
+    pthread_mutex_lock(&prof_lock);
+    int fase = -1;
+    for (int i = 0; i < prof_num_fases; i++)
+    {
+        if (strcmp(prof_nomes[i], nome) == 0)
+            fase = i;
+    }
+    if (fase < 0 && prof_num_fases < PROF_MAX_FASES)
+    {
+        fase = prof_num_fases++;
+        prof_nomes[fase] = nome;
+    }
+    pthread_mutex_unlock(&prof_lock);
+    return fase;
+}
+
+#ifdef PROF_COM_PERF
+static inline int prof_abrir_contador(uint64_t config, int lider)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = lider < 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, lider, 0);
+}
+
+// Abre o grupo de contadores da thread atual em 'fds'; se algum falhar, fecha
+// os que já abriram e fica só o tempo
+static inline int prof_abrir_perf(int *fds)
+{
+    static const uint64_t eventos[PROF_NUM_CONTADORES] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (int i = 0; i < PROF_NUM_CONTADORES; i++)
+    {
+        fds[i] = prof_abrir_contador(eventos[i], i == 0 ? -1 : fds[0]);
+        if (fds[i] < 0)
+        {
+            for (int j = 0; j < i; j++)
+            {
+                close(fds[j]);
+                fds[j] = -1;
+            }
+            return -1;
+        }
+    }
+    ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return fds[0];
+}
+#endif
+
+static inline void prof_ler_contadores(const ProfThread *t, uint64_t *valores)
+{
+#ifdef PROF_COM_PERF
+    if (t->fd_perf >= 0)
+    {
+        uint64_t grupo[1 + PROF_NUM_CONTADORES];
+        if (read(t->fd_perf, grupo, sizeof(grupo)) == (ssize_t)sizeof(grupo))
+        {
+            memcpy(valores, &grupo[1], PROF_NUM_CONTADORES * sizeof(uint64_t));
+            return;
+        }
+    }
+#else
+    (void)t;
+#endif
+    memset(valores, 0, PROF_NUM_CONTADORES * sizeof(uint64_t));
+}
+
+static inline ProfThread *prof_thread(void)
+{
+    if (prof_local == NULL)
+    {
+        ProfThread *t = calloc(1, sizeof(ProfThread));
+        t->fd_perf = -1;
+        for (int i = 0; i < PROF_NUM_CONTADORES; i++)
+            t->fds[i] = -1;
+#ifdef PROF_COM_PERF
+        t->fd_perf = prof_abrir_perf(t->fds);
+#endif
+        pthread_mutex_lock(&prof_lock);
+        t->indice = prof_num_threads;
+        if (prof_num_threads < PROF_MAX_THREADS)
+            prof_threads[prof_num_threads++] = t;
+        pthread_mutex_unlock(&prof_lock);
+        prof_local = t;
+    }
+    return prof_local;
+}
+
+static inline ProfEscopo prof_inicio(int fase)
+{
+    ProfEscopo e;
+    e.fase = fase;
+    prof_ler_contadores(prof_thread(), e.c0);
+    e.t0 = relogio();
+    return e;
+}
+
+static inline void prof_fim(ProfEscopo *e)
+{
+    double t1 = relogio();
+    if (e->fase < 0)
+        return;
+    ProfThread *t = prof_thread();
+    uint64_t c1[PROF_NUM_CONTADORES];
+    prof_ler_contadores(t, c1);
+    t->tempo[e->fase] += t1 - e->t0;
+    t->chamadas[e->fase]++;
+    for (int i = 0; i < PROF_NUM_CONTADORES; i++)
+        t->contadores[e->fase][i] += c1[i] - e->c0[i];
+}
+
+// Fecha os contadores e libera os acumuladores de todas as threads
+static inline void prof_liberar_threads(void)
+{
+    for (int i = 0; i < prof_num_threads; i++)
+    {
+#ifdef PROF_COM_PERF
+        for (int c = 0; c < PROF_NUM_CONTADORES; c++)
+        {
+            if (prof_threads[i]->fds[c] >= 0)
+                close(prof_threads[i]->fds[c]);
+        }
+#endif
+        free(prof_threads[i]);
+        prof_threads[i] = NULL;
+    }
+    prof_num_threads = 0;
+    prof_local = NULL;
+}
+
+// Imprime o resumo por thread e o total de cada fase, depois libera tudo
+static inline void prof_relatorio(FILE *saida)
+{
+    pthread_mutex_lock(&prof_lock);
+    bool com_perf = false;
+    for (int i = 0; i < prof_num_threads; i++)
+        com_perf |= prof_threads[i]->fd_perf >= 0;
+
+    fprintf(saida, "\n==== Perfil por fase (tempos inclusivos) ====\n");
+    fprintf(saida, "%-22s %6s %10s %12s %12s", "fase", "thread", "chamadas", "total_ms", "media_us");
+    if (com_perf)
+    {
+        for (int c = 0; c < PROF_NUM_CONTADORES; c++)
+            fprintf(saida, " %14s", prof_nomes_contadores[c]);
+        fprintf(saida, " %6s", "IPC");
+    }
+    fprintf(saida, "\n");
+
+    for (int f = 0; f < prof_num_fases; f++)
+    {
+        double tempo_total = 0.0;
+        long chamadas_total = 0;
+        uint64_t contadores_total[PROF_NUM_CONTADORES] = {0};
+        int threads_fase = 0;
+
+        for (int i = 0; i <= prof_num_threads; i++)
+        {
+            bool total = i == prof_num_threads;
+            if (total && threads_fase < 2)
+                break;
+            double tempo = total ? tempo_total : prof_threads[i]->tempo[f];
+            long chamadas = total ? chamadas_total : prof_threads[i]->chamadas[f];
+            const uint64_t *contadores = total ? contadores_total : prof_threads[i]->contadores[f];
+            if (chamadas == 0)
+                continue;
+
+            if (total)
+                fprintf(saida, "%-22s %6s", prof_nomes[f], "todas");
+            else
+                fprintf(saida, "%-22s %6d", prof_nomes[f], i);
+            fprintf(saida, " %10ld %12.3f %12.3f", chamadas, tempo * 1e3, tempo * 1e6 / chamadas);
+            if (com_perf)
+            {
+                for (int c = 0; c < PROF_NUM_CONTADORES; c++)
+                    fprintf(saida, " %14llu", (unsigned long long)contadores[c]);
+                fprintf(saida, " %6.2f", contadores[0] ? (double)contadores[1] / contadores[0] : 0.0);
+            }
+            fprintf(saida, "\n");
+
+            if (!total)
+            {
+                tempo_total += tempo;
+                chamadas_total += chamadas;
+                for (int c = 0; c < PROF_NUM_CONTADORES; c++)
+                    contadores_total[c] += contadores[c];
+                threads_fase++;
+            }
+        }
+    }
+    if (!com_perf)
+    {
+#ifdef PROF_COM_PERF
+        fprintf(saida, "(perf_event_open falhou: verifique /proc/sys/kernel/perf_event_paranoid)\n");
+#else
+        fprintf(saida, "(contadores de hardware desligados: compile com -DPROFILING_PERF no Linux)\n");
+#endif
+    }
+    prof_liberar_threads();
+    pthread_mutex_unlock(&prof_lock);
+}
+
+#define PROF_CONCAT_(a, b) a##b
+#define PROF_CONCAT(a, b) PROF_CONCAT_(a, b)
+
+// Mede do ponto da macro até o fim do bloco; o índice da fase fica em cache
+// numa variável estática, então só a primeira passada procura pelo nome
+#define PROF_ESCOPO(nome)                                                                              \
+    static _Atomic int PROF_CONCAT(prof_fase_, __LINE__) = -2;                                          \
+    if (atomic_load_explicit(&PROF_CONCAT(prof_fase_, __LINE__), memory_order_relaxed) == -2)          \
+        atomic_store(&PROF_CONCAT(prof_fase_, __LINE__), prof_registrar(nome));                         \
+    ProfEscopo PROF_CONCAT(prof_escopo_, __LINE__) __attribute__((cleanup(prof_fim))) =                 \
+        prof_inicio(atomic_load_explicit(&PROF_CONCAT(prof_fase_, __LINE__), memory_order_relaxed))
+
+// Como PROF_ESCOPO, para nomes que mudam em tempo de execução (procura o nome a cada vez)
+#define PROF_ESCOPO_DINAMICO(nome) \
+    ProfEscopo PROF_CONCAT(prof_escopo_, __LINE__) __attribute__((cleanup(prof_fim))) = prof_inicio(prof_registrar(nome))
+
+#define PROF_RELATORIO(saida) prof_relatorio(saida)
+
+#else
+
+#define PROF_ESCOPO(nome) ((void)0)
+#define PROF_ESCOPO_DINAMICO(nome) ((void)0)
+#define PROF_RELATORIO(saida) ((void)0)
+
+#endif
+
+#endif
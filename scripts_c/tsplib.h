@@ -0,0 +1,432 @@
+#ifndef TSPLIB_H
+#define TSPLIB_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+// Leitura de instâncias (formato .xyz.txt e TSPLIB) e gravação de tours .tour.
+//
+// Com -DDIST_INTEIRA as distâncias pré-calculadas (matriz e listas de
+// candidatos) são guardadas como int32 arredondado em vez de double: metade
+// do tráfego de memória e comparações exatas. Nos tipos de peso da TSPLIB as
+// distâncias já são inteiras por definição; nas distâncias reais do .xyz.txt
+// elas são multiplicadas por ESCALA_CUSTO antes de arredondar (senão arestas
+// menores que 0.5 viram 0), e custo_real desfaz a escala nos comprimentos.
+
+// Estrutura para representar um ponto 3D
+typedef struct
+{
+    int id;
+    double x;
+    double y;
+    double z;
+} Point;
+
+typedef enum
+{
+    PESO_EUCLIDIANO, // .xyz.txt: distância real, sem arredondamento
+    PESO_EUC_2D,
+    PESO_EUC_3D,
+    PESO_CEIL_2D,
+    PESO_CEIL_3D,
+    PESO_ATT
+} TipoPeso;
+
+typedef struct
+{
+    char nome[128];
+    int n;
+    TipoPeso tipo;
+    Point *points;
+} InstanciaTSP;
+
+#ifdef DIST_INTEIRA
+typedef int32_t custo_t;
+#define EPS_CUSTO 0
+#ifndef ESCALA_CUSTO
+#define ESCALA_CUSTO 1000.0 // Milésimos da unidade das coordenadas; 1e5 pc ainda cabe em int32
+#endif
+#else
+typedef double custo_t;
+#define EPS_CUSTO 1e-9
+#endif
+
+// Peso da aresta segundo as regras da TSPLIB (nint = arredondar para o mais próximo)
+static inline double peso_tsplib(TipoPeso tipo, const Point *a, const Point *b)
+{
+    double dx = a->x - b->x;
+    double dy = a->y - b->y;
+    double dz = a->z - b->z;
+    switch (tipo)
+    {
+    case PESO_EUC_2D:
+        return (double)(int)(sqrt(dx * dx + dy * dy) + 0.5);
+    case PESO_EUC_3D:
+        return (double)(int)(sqrt(dx * dx + dy * dy + dz * dz) + 0.5);
+    case PESO_CEIL_2D:
+        return ceil(sqrt(dx * dx + dy * dy));
+    case PESO_CEIL_3D:
+        return ceil(sqrt(dx * dx + dy * dy + dz * dz));
+    case PESO_ATT:
+    {
+        double r = sqrt((dx * dx + dy * dy + dz * dz) / 10.0);
+        int t = (int)(r + 0.5);
+        return t < r ? t + 1 : t;
+    }
+    default:
+        return sqrt(dx * dx + dy * dy + dz * dz);
+    }
+}
+
+// Fator entre o custo armazenado e a distância (só o .xyz.txt é escalado)
+static inline double escala_custo(TipoPeso tipo)
+{
+#ifdef DIST_INTEIRA
+    return tipo == PESO_EUCLIDIANO ? ESCALA_CUSTO : 1.0;
+#else
+    (void)tipo;
+    return 1.0;
+#endif
+}
+
+// Custo armazenado nas estruturas pré-calculadas (int32 no modo inteiro)
+static inline custo_t custo_tsplib(TipoPeso tipo, const Point *a, const Point *b)
+{
+#ifdef DIST_INTEIRA
+    return (custo_t)lround(peso_tsplib(tipo, a, b) * escala_custo(tipo));
+#else
+    return peso_tsplib(tipo, a, b);
+#endif
+}
+
+// Converte uma soma de custos armazenados de volta para a unidade das coordenadas
+static inline double custo_real(TipoPeso tipo, double custo)
+{
+    return custo / escala_custo(tipo);
+}
+
+// Matriz n x n de custos para os primeiros n pontos da instância
+static inline custo_t *calcular_matriz(const InstanciaTSP *inst, int n)
+{
+    custo_t *matriz = malloc((size_t)n * n * sizeof(custo_t));
+    if (matriz == NULL)
+    {
+        perror("Erro ao alocar memória");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < n; i++)
+    {
+        matriz[(size_t)i * n + i] = 0;
+        for (int j = i + 1; j < n; j++)
+        {
+            custo_t c = custo_tsplib(inst->tipo, &inst->points[i], &inst->points[j]);
+            matriz[(size_t)i * n + j] = c;
+            matriz[(size_t)j * n + i] = c;
+        }
+    }
+    return matriz;
+}
+
+// Remove espaços do início e do fim (in-place)
+static inline char *aparar(char *s)
+{
+    while (isspace((unsigned char)*s))
+        s++;
+    char *fim = s + strlen(s);
+    while (fim > s && isspace((unsigned char)fim[-1]))
+        *--fim = '\0';
+    return s;
+}
+
+static inline Point *alocar_pontos(int n)
+{
+    Point *points = malloc((n > 0 ? n : 1) * sizeof(Point));
+    if (points == NULL)
+    {
+        perror("Erro ao alocar memória");
+        exit(EXIT_FAILURE);
+    }
+    return points;
+}
+
+// Cabeçalho TSPLIB ("CHAVE : VALOR") até NODE_COORD_SECTION, depois "id x y [z]"
+static inline void ler_tsplib(FILE *arquivo, InstanciaTSP *inst)
+{
+    char linha[1024];
+    int dimensao = -1;
+    bool tem_z = false;
+    bool secao = false;
+
+    while (fgets(linha, sizeof(linha), arquivo) != NULL)
+    {
+        char *chave = aparar(linha);
+        if (strncmp(chave, "NODE_COORD_SECTION", 18) == 0)
+        {
+            secao = true;
+            break;
+        }
+        char *valor = strchr(chave, ':');
+        if (valor == NULL)
+            continue;
+        *valor++ = '\0';
+        chave = aparar(chave);
+        valor = aparar(valor);
+
+        if (strcmp(chave, "NAME") == 0)
+        {
+            strncpy(inst->nome, valor, sizeof(inst->nome) - 1);
+        }
+        else if (strcmp(chave, "DIMENSION") == 0)
+        {
+            dimensao = atoi(valor);
+        }
+        else if (strcmp(chave, "EDGE_WEIGHT_TYPE") == 0)
+        {
+            if (strcmp(valor, "EUC_2D") == 0)
+                inst->tipo = PESO_EUC_2D;
+            else if (strcmp(valor, "EUC_3D") == 0)
+                inst->tipo = PESO_EUC_3D, tem_z = true;
+            else if (strcmp(valor, "CEIL_2D") == 0)
+                inst->tipo = PESO_CEIL_2D;
+            else if (strcmp(valor, "CEIL_3D") == 0)
+                inst->tipo = PESO_CEIL_3D, tem_z = true;
+            else if (strcmp(valor, "ATT") == 0)
+                inst->tipo = PESO_ATT;
+            else
+            {
+                fprintf(stderr, "EDGE_WEIGHT_TYPE nao suportado: %s\n", valor);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    if (!secao || dimensao <= 0)
+    {
+        fprintf(stderr, "Arquivo TSPLIB sem DIMENSION ou NODE_COORD_SECTION\n");
+        exit(EXIT_FAILURE);
+    }
+
+    inst->n = dimensao;
+    inst->points = alocar_pontos(dimensao);
+    for (int i = 0; i < dimensao; i++)
+    {
+        Point *p = &inst->points[i];
+        p->z = 0.0;
+        int lidos = tem_z ? fscanf(arquivo, "%d %lf %lf %lf", &p->id, &p->x, &p->y, &p->z)
+                          : fscanf(arquivo, "%d %lf %lf", &p->id, &p->x, &p->y);
+        if (lidos != (tem_z ? 4 : 3))
+        {
+            fprintf(stderr, "Erro ao ler coordenadas do arquivo\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// Formato .xyz.txt: "x y z" por linha, com uma linha opcional só com a quantidade
+static inline void ler_xyz(FILE *arquivo, const char *primeira, InstanciaTSP *inst)
+{
+    double x, y, z;
+    int linhas = 0;
+    char extra;
+    bool cabecalho = sscanf(primeira, "%d %c", &linhas, &extra) == 1;
+
+    if (!cabecalho)
+    {
+        // Contar o número de linhas no arquivo
+        rewind(arquivo);
+        linhas = 0;
+        while (fscanf(arquivo, "%lf %lf %lf", &x, &y, &z) == 3)
+        {
+            linhas++;
+        }
+        rewind(arquivo);
+    }
+
+    inst->n = linhas;
+    inst->tipo = PESO_EUCLIDIANO;
+    inst->points = alocar_pontos(linhas);
+    for (int i = 0; i < linhas; i++)
+    {
+        if (fscanf(arquivo, "%lf %lf %lf", &inst->points[i].x, &inst->points[i].y, &inst->points[i].z) != 3)
+        {
+            fprintf(stderr, "Erro ao ler coordenadas do arquivo\n");
+            exit(EXIT_FAILURE);
+        }
+        inst->points[i].id = i + 1;
+    }
+}
+
+// Função para ler uma instância; detecta o formato pelo conteúdo do arquivo
+static inline void ler_instancia(const char *nome_arquivo, InstanciaTSP *inst)
+{
+    FILE *arquivo = fopen(nome_arquivo, "r");
+    if (arquivo == NULL)
+    {
+        perror("Erro ao abrir o arquivo");
+        exit(EXIT_FAILURE);
+    }
+
+    memset(inst, 0, sizeof(*inst));
+    const char *base = strrchr(nome_arquivo, '/');
+    const char *base_win = strrchr(nome_arquivo, '\\');
+    if (base_win != NULL && (base == NULL || base_win > base))
+        base = base_win;
+    strncpy(inst->nome, base != NULL ? base + 1 : nome_arquivo, sizeof(inst->nome) - 1);
+    char *ponto = strchr(inst->nome, '.');
+    if (ponto != NULL)
+        *ponto = '\0';
+
+    char linha[1024];
+    char *primeira = NULL;
+    while (fgets(linha, sizeof(linha), arquivo) != NULL)
+    {
+        primeira = aparar(linha);
+        if (*primeira != '\0')
+            break;
+    }
+    if (primeira == NULL)
+    {
+        fprintf(stderr, "Arquivo vazio: %s\n", nome_arquivo);
+        exit(EXIT_FAILURE);
+    }
+
+    if (isalpha((unsigned char)*primeira))
+    {
+        rewind(arquivo);
+        ler_tsplib(arquivo, inst);
+    }
+    else
+    {
+        ler_xyz(arquivo, primeira, inst);
+    }
+    fclose(arquivo);
+}
+
+static inline void liberar_instancia(InstanciaTSP *inst)
+{
+    free(inst->points);
+    inst->points = NULL;
+    inst->n = 0;
+}
+
+// Lê um tour .tour (ids após TOUR_SECTION, até -1) ou uma lista simples de ids
+static inline int *ler_tour(const char *nome_arquivo, int *tamanho)
+{
+    FILE *arquivo = fopen(nome_arquivo, "r");
+    if (arquivo == NULL)
+    {
+        perror("Erro ao abrir o tour");
+        exit(EXIT_FAILURE);
+    }
+
+    char linha[1024];
+    long inicio_ids = 0;
+    while (fgets(linha, sizeof(linha), arquivo) != NULL)
+    {
+        char *conteudo = aparar(linha);
+        if (*conteudo == '\0')
+            continue;
+        if (!isalpha((unsigned char)*conteudo))
+            break; // lista simples, sem cabeçalho
+        if (strncmp(conteudo, "TOUR_SECTION", 12) == 0)
+        {
+            inicio_ids = ftell(arquivo);
+            break;
+        }
+    }
+
+    int capacidade = 1024, total = 0, id;
+    int *ids = malloc(capacidade * sizeof(int));
+    fseek(arquivo, inicio_ids, SEEK_SET);
+    while (fscanf(arquivo, "%d", &id) == 1 && id != -1)
+    {
+        if (total == capacidade)
+        {
+            capacidade *= 2;
+            ids = realloc(ids, capacidade * sizeof(int));
+        }
+        ids[total++] = id;
+    }
+    fclose(arquivo);
+
+    *tamanho = total;
+    return ids;
+}
+
+// Grava os pontos no formato .xyz.txt (uma linha "x y z" por ponto, na ordem dos ids)
+static inline bool gravar_xyz(const char *nome_arquivo, const Point *points, int n)
+{
+    FILE *arquivo = fopen(nome_arquivo, "w");
+    if (arquivo == NULL)
+    {
+        perror("Erro ao gravar as coordenadas");
+        return false;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        fprintf(arquivo, " %.6f %.6f %.6f\n", points[i].x, points[i].y, points[i].z);
+    }
+    fclose(arquivo);
+    return true;
+}
+
+// Grava a instância em formato TSPLIB, mantendo o EDGE_WEIGHT_TYPE e os ids
+static inline bool gravar_tsplib(const char *nome_arquivo, const InstanciaTSP *inst)
+{
+    static const char *const nomes_peso[] = {"EUC_3D", "EUC_2D", "EUC_3D", "CEIL_2D", "CEIL_3D", "ATT"};
+    bool tem_z = inst->tipo == PESO_EUC_3D || inst->tipo == PESO_CEIL_3D;
+    FILE *arquivo = fopen(nome_arquivo, "w");
+    if (arquivo == NULL)
+    {
+        perror("Erro ao gravar a instancia");
+        return false;
+    }
+
+    fprintf(arquivo, "NAME : %s\n", inst->nome);
+    fprintf(arquivo, "TYPE : TSP\n");
+    fprintf(arquivo, "DIMENSION : %d\n", inst->n);
+    fprintf(arquivo, "EDGE_WEIGHT_TYPE : %s\n", nomes_peso[inst->tipo]);
+    fprintf(arquivo, "NODE_COORD_SECTION\n");
+    for (int i = 0; i < inst->n; i++)
+    {
+        const Point *p = &inst->points[i];
+        if (tem_z)
+            fprintf(arquivo, "%d %.6f %.6f %.6f\n", p->id, p->x, p->y, p->z);
+        else
+            fprintf(arquivo, "%d %.6f %.6f\n", p->id, p->x, p->y);
+    }
+    fprintf(arquivo, "EOF\n");
+    fclose(arquivo);
+    return true;
+}
+
+// Grava o tour no formato .tour da TSPLIB (ids dos pontos, terminado por -1)
+static inline bool gravar_tour(const char *nome_arquivo, const char *nome, const int *ids, int n, double comprimento)
+{
+    FILE *arquivo = fopen(nome_arquivo, "w");
+    if (arquivo == NULL)
+    {
+        perror("Erro ao gravar o tour");
+        return false;
+    }
+
+    fprintf(arquivo, "NAME : %s.tour\n", nome);
+    fprintf(arquivo, "COMMENT : Length = %.6f\n", comprimento);
+    fprintf(arquivo, "TYPE : TOUR\n");
+    fprintf(arquivo, "DIMENSION : %d\n", n);
+    fprintf(arquivo, "TOUR_SECTION\n");
+    for (int i = 0; i < n; i++)
+    {
+        fprintf(arquivo, "%d\n", ids[i]);
+    }
+    fprintf(arquivo, "-1\nEOF\n");
+    fclose(arquivo);
+    return true;
+}
+
+#endif